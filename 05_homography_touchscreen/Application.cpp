@@ -8,6 +8,10 @@
 
 #include "Application.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
 #include <boost/thread.hpp>
 
 #define _USE_MATH_DEFINES
@@ -17,10 +21,16 @@
 #include "game/GameServer.h"
 #include "game/Game.h"
 #include "game/GameUnit.h"
-
-#include "DepthCamera.h"
-#include "DepthCameraException.h"
+#include "game/GameState.h"
+#include "game/Profiler.h"
+#include "game/LatencyTracer.h"
+#include "game/Logging.h"
+#include "game/Atomic.h"
+#include "game/ThreadPool.h"
+
+#include "FrameSource.h"
 #include "Calibration.h"
+#include "SessionRecorder.h"
 #include "OpenCVUtils.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -55,113 +65,70 @@ void Application::warpImage()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Application::processFrame()
+void Application::processFrame(Frame &frame)
 {
 	////////////////////////////////////////////////////////////////////////////
 	//
 	// To do (assignment #2):
 	//
-	// This method will be called every frame of the camera. Insert code here in
-	// order to recognize touch. These images will help you doing so:
+	// This method will be called every frame of the camera on the detection
+	// thread. Insert code here in order to recognize touch. These images will
+	// help you doing so:
+	//
+	// * frame.rgbImage: The image of the Kinect's RGB camera
+	// * frame.depthImage: The image of the Kinects's depth sensor
 	//
-	// * m_rgbImage: The image of the Kinect's RGB camera
-	// * m_depthImage: The image of the Kinects's depth sensor
-	// * m_gameImage: The undistorted image that the game renders
-	// * m_renderImage: The final image distorted in a way that it appears
-	//                  undistorted on the floor.
+	// Touch found is stored in the frame for the display stage.
 	//
 	////////////////////////////////////////////////////////////////////////////
 	
-	// Sample code brightening up the depth image to make it visible
-	m_depthImage *= 32;
 	bool new_input = false;
+	cv::Mat cameraToPhysical;
 
-	// save depthimage to temporary buffer and convert it to 8bit so 
-	// openCV doesn't crash. Shoutout to Team EpicHigh5
-	m_depthImage.copyTo(m_working);
-	//cv::perspectiveTransform(m_depthImage, m_working, m_calibration->cameraToPhysical());
-	m_working.convertTo(m_working, CV_8UC1, 0.006, 0); // very important magic number
-	
-
-	if (!initialized)
 	{
-		std::cout << "Initialize!\n\n";
-		m_working.copyTo(m_base);
-		initialized = 1;
-	}
+		boost::lock_guard<boost::mutex> lock(m_calibrationMutex);
 
-	// generic shit: remove floor from image
-	cv::absdiff(m_base, m_working, m_working);
+		// Nothing to detect before projector and camera are calibrated
+		if (!m_calibration->hasTerminated())
+			return;
 
-	// lighten shit up
-	m_working *= 2;
-
-	int thresh_upper = 50;
-	int thresh_lower = 10;
-	cv::threshold(m_working, m_working, thresh_upper, 0, 4);
-	cv::threshold(m_working, m_working, thresh_lower, 0, 3);
-
-	// now all thats left is feet touching the floor
-
-	// first we have to declare an array of arrays to store our contours
-
-	std::vector<std::vector<cv::Point>> contours; 
-
-	// then we look for contours
-	cv::findContours(m_working, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
+		// The play area is derived from the calibration once, the background
+		// is captured on the first frame
+		if (!initialized)
+		{
+			m_touchDetector.setPlayArea(m_calibration->cameraCoordinates(),
+				frame.depthImage.size());
+			m_touchDetector.setBackground(frame.depthImage);
+			Logging::debug("Captured the background depth image.");
+			initialized = 1;
+		}
 
-	// now we try to find the biggest contour...
+		cameraToPhysical = m_calibration->cameraToPhysical().clone();
+	}
 
-	double maxContourSize = 0;
-	double currContourSize;
-	int maxContourIndex= -1;
+	long downsamplingFactor = Atomic::load(&m_downsamplingFactor);
 
+	if (downsamplingFactor != m_touchDetector.downsamplingFactor())
+		m_touchDetector.setDownsamplingFactor(downsamplingFactor);
 
-	// ... of course only if we have found any
+	// now all thats left is feet touching the floor, the detector fits an
+	// ellipse to the biggest one
+	cv::RotatedRect foot;
+	bool isTouching;
 
-	if(contours.size() > 0)
 	{
-			int i;
-		for (i = 0; i < contours.size(); i++) {
-
-			currContourSize = cv::contourArea(contours[i]);
+		PROFILE_SCOPE("detectTouch");
 
-			if (currContourSize > maxContourSize) {
-
-				maxContourSize = currContourSize;
-				maxContourIndex = i;
-
-			}
-
-		}
+		isTouching = m_touchDetector.detect(frame.depthImage, foot);
 	}
 
-	// have we found a suitable contour?
-	if (maxContourIndex >= 0)
+	if (isTouching)
 	{
-		std::vector<cv::Point> maxContour = contours[maxContourIndex]; 
-
-		//std::cout << maxContour.size() << "\n";
-
-
-		// small contours are probably just noise. only proceed if the contour is large
-		if (maxContour.size() > 100)
-		{
-			// fitting ellipses
-
-
-			cv::Point input_proj;
-			cv::RotatedRect foot = cv::fitEllipse(maxContour);
-			//std::cout << foot.center.x << " " << foot.center.y << "--> ";
-			input = m_calibration->cameraToPhysical() * foot.center;
-			input_proj = m_calibration->physicalToProjector() *  m_calibration->cameraToPhysical() * foot.center;
-			//circle(m_renderImage, foot.center, 10, cv::Scalar(100,150,200,0), 2);
-			//std::cout << foot.center.x << " " << foot.center.y << "\n";
-			circle(m_renderImage, input, 10, cv::Scalar(200,100,200,0), 2);
-			new_input=1;
-			std::cout << input.x << "|" << input.y << " --- ";
-		}
-	} 
+		input = cameraToPhysical * foot.center;
+		frame.isTouching = true;
+		frame.input = input;
+		new_input=1;
+	}
 
 	////////////////////////////////////////////////////////////////////////////
 	//
@@ -178,30 +145,30 @@ void Application::processFrame()
 
 	int i = 0;
 	int m = 5; // no. of units. being generic is so fun!
-	int tolerance = 40;
+
+	// look at one consistent frame of the game, the network thread may update
+	// the units meanwhile
+	GameStatePtr gameState = m_gameClient->game()->displayedState();
+
+	if (!gameState)
+		return;
+
+	// was a unit just selected or deselected? the server tests the tap
+	// against the units as they are displayed now, so fast units aren't
+	// missed because of the latency
+	if (new_input)
+		m_gameClient->game()->selectUnit(input);
 
 	for (i = 0; i<m; i++)
 	{
-		GameUnitPtr u = m_gameClient->game()->unitByIndex(i);
+		const GameUnitState *u = gameState->unitByIndex(i);
 
-		if(new_input)
-		{
-			// was this unit just selected or deselected?
-			int distance = cv::norm(u->position() - input);
-			//std::cout << distance << " ";
-			std::cout << u->position().x << "|" << u->position().y << " ";
-			if (distance < tolerance)
-			{
-				// toggle highlightedness of unit
-				std::cout << "You tapped Unit no. " << (i+1) << "(distance: " << distance << ")\n";
-				//u->setHighlighted(!u->isHighlighted());
-				m_gameClient->game()->highlightUnit(i, !u->isHighlighted());
-			}
-		}
+		if (!u)
+			continue;
 
 		// everybody selected, please come to the last known foot position
 		// or you won't get any pudding
-		if(u->isHighlighted() && u->isLiving())
+		if(u->isHighlighted && u->isLiving)
 		{
 			//float angle = std::atan(float(u->position().y - input.y) / (input.x - u->position().x ));
 		float angle;
@@ -213,18 +180,21 @@ void Application::processFrame()
 		} else if (wurst == 0){ if(conchita > 0){angle = M_PI;} else { 	angle = 0.0;}
 		} else { if(wurst > 0){	angle = 3 * M_PI / 2;} else {angle = M_PI / 2;}
 }
-			m_gameClient->game()->moveUnit(i, angle, 1.0f);
+			// Trace the input if measuring latency
+			uint32_t traceID = LatencyTracer::instance()->beginTrace(
+				frame.captureTime);
+
+			m_gameClient->game()->moveUnit(i, angle, 1.0f, traceID);
 		}
 
 
 
 	}
-	std::cout << "\n";
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Application::handleSkeletonTracked(XnUInt16 userID)
+void Application::handleSkeletonTracked(unsigned int userID)
 {
 	////////////////////////////////////////////////////////////////////////////
 	//
@@ -236,18 +206,22 @@ void Application::handleSkeletonTracked(XnUInt16 userID)
 	//
 	////////////////////////////////////////////////////////////////////////////
 
-	xn::SkeletonCapability skeletonCapability
-		= DepthCamera::instance()->userGenerator().GetSkeletonCap();
+	// Works for live cameras and replayed sessions alike
+	SessionSkeleton skeleton;
+
+	if (!m_frameSource->trackedSkeleton(userID, skeleton))
+		return;
 
-	// Access joint positions like this:
-	// skeletonCapability->GetSkeletonJointPosition(...);
+	// Access joint positions like this, in millimeters:
+	// skeleton.joints[XN_SKEL_RIGHT_HAND - 1].x
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Application::Application(int argc, char *argv[])
+Application::Application(int argc, char *argv[], FrameSource *frameSource)
 {
 	m_isFinished = false;
+	m_frameSource = frameSource;
 
 	m_gameServer = new GameServer;
 	m_gameClient = new GameClient;
@@ -255,8 +229,6 @@ Application::Application(int argc, char *argv[])
 	m_gameServer->run();
 	m_gameServer->loadGame(1);
 
-	boost::this_thread::sleep(boost::posix_time::milliseconds(100));
-
 	m_gameClient->run();
 
 	if (argc > 1)
@@ -265,44 +237,71 @@ Application::Application(int argc, char *argv[])
 	{
 		m_gameClient->connectToServer("127.0.0.1");
 
-		std::cout << "[Info] Connected to localhost (to connect to another "
-			<< "server, pass a server address as the first argument)."
-			<< std::endl;
+		Logging::info("Connected to localhost (to connect to another server, "
+			"pass a server address as the first argument).");
 	}
 
-	try
-	{
-		DepthCamera::instance()->onSkeletonTracked.connect(
-			boost::bind(&Application::handleSkeletonTracked, this, _1));
-	}
-	catch (DepthCameraException)
-	{
-
-	}
+	m_frameSource->onSkeletonTracked.connect(
+		boost::bind(&Application::handleSkeletonTracked, this, _1));
 
 	// Start the calibration
 	m_calibration = new Calibration;
 
+	m_sessionRecorder = new SessionRecorder;
+
+	// The number of detection threads may be passed as the third argument,
+	// by default all hardware threads are used
+	unsigned int numberOfDetectionThreads = 0;
+
+	if (argc > 3)
+		numberOfDetectionThreads = std::max(0, atoi(argv[3]));
+
+	m_detectionThreadPool = new ThreadPool(numberOfDetectionThreads);
+	m_touchDetector.setThreadPool(m_detectionThreadPool);
+	m_downsamplingFactor = m_touchDetector.downsamplingFactor();
+
     // Create necessary images
-	m_rgbImage = cv::Mat(480, 640, CV_8UC3);
-	m_depthImage = cv::Mat(480, 640, CV_16UC1);
 	m_gameImage = cv::Mat(480, 480, CV_8UC3);
 	m_renderImage = cv::Mat(600, 800, CV_8UC3);
-	m_working = cv::Mat(480, 640, CV_8UC1);
 
 	// initialize initialize
 	initialized = false;
+
+	m_captureToDisplayStage
+		= Profiler::instance()->stage("latency.captureToDisplay");
+
+	// Start the capture and detection stages of the pipeline
+	m_frame = NULL;
+	m_isStopping = 0;
+	m_droppedFrames = 0;
+
+	m_captureThread = boost::thread(
+		boost::bind(&Application::captureFrames, this));
+	m_detectionThread = boost::thread(
+		boost::bind(&Application::detectTouches, this));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 Application::~Application()
 {
+	// Stop the pipeline before the objects it uses are deleted
+	Atomic::store(&m_isStopping, 1);
+	m_captureThread.join();
+	m_detectionThread.join();
+
+	Profiler::instance()->dump();
+
+	std::stringstream message;
+	message << Atomic::load(&m_droppedFrames)
+		<< " frames dropped by the pipeline.";
+	Logging::info(message.str());
+
+	Logging::instance()->flush();
+
 	m_gameClient->stop();
 	m_gameServer->stop();
 
-	DepthCamera::deleteInstance();
-
 	if (m_gameClient)
 		delete m_gameClient;
 
@@ -311,60 +310,208 @@ Application::~Application()
 
 	if (m_calibration)
 		delete m_calibration;
+
+	if (m_detectionThreadPool)
+		delete m_detectionThreadPool;
+
+	if (m_sessionRecorder)
+		delete m_sessionRecorder;
+
+	if (m_frameSource)
+		delete m_frameSource;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Application::loop()
+void Application::captureFrames()
 {
-	try
+	while (!Atomic::load(&m_isStopping))
 	{
-		// Grab new images from the Kinect's cameras
-		if (DepthCamera::hasInstance())
-			DepthCamera::instance()->frameFromCamera(m_rgbImage, m_depthImage, CV_16UC1);
+		Frame *frame = m_framePool.acquire();
+		bool hasFrame;
+
+		{
+			PROFILE_SCOPE("capture");
+
+			// Grab new images from the Kinect's cameras or another frame source
+			hasFrame = m_frameSource->readFrame(frame->rgbImage,
+				frame->depthImage);
+			frame->captureTime = boost::chrono::steady_clock::now();
+		}
+
+		if (!hasFrame)
+		{
+			m_framePool.release(frame);
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+			continue;
+		}
+
+		{
+			boost::lock_guard<boost::mutex> lock(m_recordingMutex);
+
+			if (m_sessionRecorder->isOpen())
+			{
+				PROFILE_SCOPE("record");
+
+				SessionSkeletons skeletons;
+				m_frameSource->trackedSkeletons(skeletons);
+				m_sessionRecorder->record(frame->rgbImage, frame->depthImage,
+					skeletons);
+			}
+		}
+
+		{
+			PROFILE_SCOPE("flip");
+
+			cv::flip(frame->rgbImage, frame->rgbImage, 1);
+			cv::flip(frame->depthImage, frame->depthImage, 1);
+		}
+
+		Frame *evictedFrame;
+
+		if (m_capturedFrames.push(frame, evictedFrame))
+		{
+			m_framePool.release(evictedFrame);
+			Atomic::increment(&m_droppedFrames);
+		}
 	}
-	catch (DepthCameraException)
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Application::detectTouches()
+{
+	while (!Atomic::load(&m_isStopping))
 	{
+		Frame *frame;
 
+		if (!m_capturedFrames.pop(frame))
+		{
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+			continue;
+		}
+
+		{
+			PROFILE_SCOPE("processFrame");
+
+			// Process the current frame
+			processFrame(*frame);
+		}
+
+		Frame *evictedFrame;
+
+		if (m_detectedFrames.push(frame, evictedFrame))
+		{
+			m_framePool.release(evictedFrame);
+			Atomic::increment(&m_droppedFrames);
+		}
 	}
+}
 
-	cv::flip(m_rgbImage, m_rgbImage, 1);
-	cv::flip(m_depthImage, m_depthImage, 1);
+////////////////////////////////////////////////////////////////////////////////
 
+void Application::loop()
+{
 	int key;
 
-	// If projector and camera aren't calibrated, do this and nothing else
-	if (!m_calibration->hasTerminated())
+	// Keep the window responsive while waiting for the next frame
+	if (!m_detectedFrames.pop(m_frame))
 	{
-		m_calibration->loop(m_rgbImage, m_depthImage);
-
-		key = cv::waitKey(1);
+		m_frame = NULL;
 
-		if (key == 'q')
+		if (cv::waitKey(1) == 'q')
 			m_isFinished = true;
 
 		return;
 	}
 
-	if (m_gameClient->game())
-		m_gameClient->game()->render(m_gameImage);
+	PROFILE_SCOPE("frame");
 
-	// Copy the game image into the finally rendered image
-	m_renderImage = cv::Mat::zeros(600, 800, CV_8UC3);
-	cv::Mat renderRegionOfInterest = m_renderImage(cv::Rect(0, 0, 480, 480));
-	m_gameImage.copyTo(renderRegionOfInterest);
+	{
+		boost::lock_guard<boost::mutex> lock(m_calibrationMutex);
+
+		// If projector and camera aren't calibrated, do this and nothing else
+		if (!m_calibration->hasTerminated())
+		{
+			{
+				PROFILE_SCOPE("calibration");
+
+				m_calibration->loop(m_frame->rgbImage, m_frame->depthImage);
+			}
 
-	// Undistort the image
-	warpImage();
+			// Mouse clicks are handled while waiting for keys
+			key = cv::waitKey(1);
 
-	// Process the current frame
-	processFrame();
+			if (key == 'q')
+				m_isFinished = true;
 
-	// Display the image
-	cv::imshow("UIST 2001 game", m_renderImage);
+			m_framePool.release(m_frame);
+			m_frame = NULL;
 
-	// Check for key input
-	key = cv::waitKey(1);
+			return;
+		}
+	}
+
+	// The game state being rendered, kept to trace latencies after display
+	GameStatePtr gameState;
+
+	{
+		PROFILE_SCOPE("render");
+
+		if (m_gameClient->game())
+		{
+			gameState = m_gameClient->game()->displayedState();
+
+			if (gameState)
+				m_gameClient->game()->render(m_gameImage, *gameState);
+			else
+				m_gameClient->game()->render(m_gameImage);
+		}
+	}
+
+	{
+		PROFILE_SCOPE("copy");
+
+		// Copy the game image into the finally rendered image
+		m_renderImage = cv::Mat::zeros(600, 800, CV_8UC3);
+		cv::Mat renderRegionOfInterest = m_renderImage(cv::Rect(0, 0, 480, 480));
+		m_gameImage.copyTo(renderRegionOfInterest);
+	}
+
+	{
+		PROFILE_SCOPE("warp");
+
+		// Undistort the image
+		warpImage();
+	}
+
+	if (m_frame->isTouching)
+		circle(m_renderImage, m_frame->input, 10, cv::Scalar(200,100,200,0), 2);
+
+	{
+		PROFILE_SCOPE("imshow");
+
+		// Display the image
+		cv::imshow("UIST 2001 game", m_renderImage);
+	}
+
+	Profiler::instance()->record(m_captureToDisplayStage,
+		boost::chrono::steady_clock::now() - m_frame->captureTime);
+
+	if (gameState && LatencyTracer::instance()->isEnabled())
+	{
+		const GameUnitStates &units = gameState->units();
+
+		for (unsigned int i = 0; i < units.size(); i++)
+			LatencyTracer::instance()->markDisplayed(units[i].traceID);
+	}
+
+	{
+		PROFILE_SCOPE("waitKey");
+
+		// Check for key input
+		key = cv::waitKey(1);
+	}
 
 	switch (key)
 	{
@@ -424,23 +571,100 @@ void Application::loop()
 			break;
 
 		case 'c':
+		{
+			boost::lock_guard<boost::mutex> lock(m_calibrationMutex);
+
 			// Recalibrate projector and camera
 			m_calibration->restart();
+
+			// The play area and the background change with the calibration
+			initialized = false;
+			break;
+		}
+
+		case 'r':
+			// Start or stop recording the camera frames
+			toggleRecording();
+			break;
+
+		case 't':
+			// Log the latencies of all profiled stages
+			Profiler::instance()->dump();
+			break;
+
+		case 'l':
+			// Start or stop measuring the latency of touch input
+			toggleLatencyTracing();
+			break;
+
+		case 'f':
+			// Switch between coarse-to-fine and full resolution detection
+			toggleDownsampling();
 			break;
 	}
+
+	m_framePool.release(m_frame);
+	m_frame = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Application::makeScreenshots()
 {
-	cv::imwrite("raw.png", m_rgbImage);
-	cv::imwrite("depth.png", m_depthImage);
+	if (m_frame)
+	{
+		cv::imwrite("raw.png", m_frame->rgbImage);
+		cv::imwrite("depth.png", m_frame->depthImage);
+	}
+
 	cv::imwrite("game.png", m_renderImage);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Application::toggleRecording()
+{
+	boost::lock_guard<boost::mutex> lock(m_recordingMutex);
+
+	if (m_sessionRecorder->isOpen())
+		m_sessionRecorder->close();
+	else
+		m_sessionRecorder->open("session.jnsr");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Application::toggleLatencyTracing()
+{
+	LatencyTracer *latencyTracer = LatencyTracer::instance();
+	latencyTracer->setEnabled(!latencyTracer->isEnabled());
+
+	if (latencyTracer->isEnabled())
+		Logging::info("Measuring input latency (press t to show).");
+	else
+		Logging::info("Stopped measuring input latency.");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Application::toggleDownsampling()
+{
+	long factor = Atomic::load(&m_downsamplingFactor) * 2;
+
+	if (factor > 4)
+		factor = 1;
+
+	// Applied by the detection thread with the next frame
+	Atomic::store(&m_downsamplingFactor, factor);
+
+	std::stringstream message;
+	message << "Detecting touch in depth images downsampled by " << factor
+		<< ".";
+	Logging::info(message.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool Application::isFinished()
 {
 	return m_isFinished;
@@ -9,18 +9,24 @@
 #ifndef __APPLICATION_H
 #define __APPLICATION_H
 
+#include <boost/chrono.hpp>
+#include <boost/thread.hpp>
+
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include "FramePool.h"
+#include "FrameQueue.h"
+#include "TouchDetector.h"
+#include "game/Profiler.h"
+
 // Forward declarations
-class DepthCamera;
 class GameClient;
 class GameServer;
 class Calibration;
-
-// OpenNI
-#include <XnCppWrapper.h>
-#include <XnOpenNI.h>
+class FrameSource;
+class SessionRecorder;
+class ThreadPool;
 
 ////////////////////////////////////////////////////////////////////////////////
 //
@@ -31,32 +37,68 @@ class Calibration;
 class Application
 {
 	public:
-		Application(int argc, char *argv[]);
+		// Takes ownership of the frame source
+		Application(int argc, char *argv[], FrameSource *frameSource);
 		~Application();
 
 		void loop();
 
 		void warpImage();
-		void processFrame();
-		void handleSkeletonTracked(XnUInt16 userID);
+		void processFrame(Frame &frame);
+		void handleSkeletonTracked(unsigned int userID);
 
 		void makeScreenshots();
+		void toggleRecording();
+		void toggleLatencyTracing();
+		void toggleDownsampling();
 		void clearOutputImage();
 
 		bool isFinished();
 
 	protected:
+		// Pipeline stages running on their own threads, the display stage
+		// runs in loop() because highgui has to stay on the main thread
+		void captureFrames();
+		void detectTouches();
+
 		GameClient *m_gameClient;
 		GameServer *m_gameServer;
 
-		cv::Mat m_rgbImage;
-		cv::Mat m_depthImage;
+		// Frames pass from capture to detection to display. Each stage drops
+		// the oldest frame waiting if the next stage falls behind.
+		FramePool m_framePool;
+		FrameQueue<Frame*, 2> m_capturedFrames;
+		FrameQueue<Frame*, 2> m_detectedFrames;
+
+		boost::thread m_captureThread;
+		boost::thread m_detectionThread;
+		volatile long m_isStopping;
+		volatile long m_droppedFrames;
+
+		// The frame being displayed
+		Frame *m_frame;
+
+		Profiler::StageID m_captureToDisplayStage;
+
 		cv::Mat m_gameImage;
 		cv::Mat m_renderImage;
-		cv::Mat m_working;
-		cv::Mat m_base;
 
+		// Used by the detection thread only
+		TouchDetector m_touchDetector;
+
+		// The downsampling factor requested for the touch detector
+		volatile long m_downsamplingFactor;
+
+		// Threads segmenting the depth image in parallel
+		ThreadPool *m_detectionThreadPool;
+
+		// The calibration is shared by the detection and display stages
 		Calibration *m_calibration;
+		boost::mutex m_calibrationMutex;
+
+		FrameSource *m_frameSource;
+		SessionRecorder *m_sessionRecorder;
+		boost::mutex m_recordingMutex;
 
 		bool m_isFinished;
 		bool initialized;
@@ -263,6 +263,13 @@ const cv::Mat &Calibration::cameraToPhysical() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+const std::vector<cv::Point2f> &Calibration::cameraCoordinates() const
+{
+	return m_cameraCoordinates;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void mouseCallback(int event, int x, int y, int flags, void *pointer)
 {
 	if (event != CV_EVENT_LBUTTONDOWN)
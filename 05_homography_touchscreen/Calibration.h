@@ -38,6 +38,9 @@ class Calibration
 		const cv::Mat &physicalToCamera() const;
 		const cv::Mat &cameraToPhysical() const;
 
+		// The corners of the play area in camera space
+		const std::vector<cv::Point2f> &cameraCoordinates() const;
+
 	protected:
 		void calibrate(const cv::Mat &rgbImage);
 		void calibrateProjector();
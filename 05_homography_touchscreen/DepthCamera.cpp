@@ -11,6 +11,7 @@
 #include <iostream>
 
 #include "DepthCameraException.h"
+#include "game/Profiler.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 //
@@ -129,6 +130,10 @@ DepthCamera::DepthCamera()
 DepthCamera::~DepthCamera()
 {
 	m_context.Release();
+
+	// The instance may also be deleted as a frame source
+	if (s_instance == this)
+		s_instance = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -170,27 +175,39 @@ bool DepthCamera::frameFromVideo(cv::Mat &rgbImage, cv::Mat &depthImage)
 int DepthCamera::frameFromCamera(cv::Mat &rgbImage, cv::Mat &depthImage,
 								 int depthType)
 {
-	// Read next available data
-	XnStatus status = m_context.WaitAndUpdateAll();
+	XnStatus status;
 	XnUserID userIDs[15];
 	XnUInt16 numberOfUsers = 15;
 
+	{
+		PROFILE_SCOPE("camera.wait");
+
+		// Read next available data
+		status = m_context.WaitAndUpdateAll();
+	}
+
 	if (status != XN_STATUS_OK)
 		return status;
 
-	// Process the data
-	m_depthGenerator.GetMetaData(m_depthMetaData);
-	m_imageGenerator.GetMetaData(m_imageMetaData);
-	m_userGenerator.GetUsers(userIDs, numberOfUsers);
+	{
+		PROFILE_SCOPE("camera.convert");
 
-	// convert depth
-	if (depthType == CV_16UC1)
-		convertDepthToMat_16UC1(m_depthMetaData, depthImage);
-	else
-		convertDepthToMat_8UC3(m_depthMetaData, depthImage);
+		// Process the data
+		m_depthGenerator.GetMetaData(m_depthMetaData);
+		m_imageGenerator.GetMetaData(m_imageMetaData);
+		m_userGenerator.GetUsers(userIDs, numberOfUsers);
+
+		// convert depth
+		if (depthType == CV_16UC1)
+			convertDepthToMat_16UC1(m_depthMetaData, depthImage);
+		else
+			convertDepthToMat_8UC3(m_depthMetaData, depthImage);
 
-	// convert rgb
-	convertRGBToMat(m_imageMetaData, rgbImage);
+		// convert rgb
+		convertRGBToMat(m_imageMetaData, rgbImage);
+	}
+
+	PROFILE_SCOPE("camera.skeleton");
 
 	if (numberOfUsers > 0)
 		for (XnUInt16 i = 0; i < numberOfUsers; i++)
@@ -210,6 +227,13 @@ int DepthCamera::frameFromCamera(cv::Mat &rgbImage, cv::Mat &depthImage,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool DepthCamera::readFrame(cv::Mat &rgbImage, cv::Mat &depthImage)
+{
+	return frameFromCamera(rgbImage, depthImage, CV_16UC1) == XN_STATUS_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool DepthCamera::frameFromFile(std::string rgbFile, cv::Mat &rgbImage,
 							   std::string depthFile, cv::Mat &depthImage)
 {
@@ -223,7 +247,7 @@ bool DepthCamera::frameFromFile(std::string rgbFile, cv::Mat &rgbImage,
 	if (depthImage.rows <= 0 || depthImage.cols <= 0)
 		return false;
 
-	return 0;
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -245,6 +269,27 @@ void DepthCamera::convertDepth_8UC3_to_16UC1(const cv::Mat &depth8,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void DepthCamera::convertDepth_16UC1_to_8UC3(const cv::Mat &depth16,
+											 cv::Mat &depth8)
+{
+	depth8.create(depth16.rows, depth16.cols, CV_8UC3);
+
+	for (int row = 0; row < depth16.rows; row++)
+	{
+		const ushort *in = depth16.ptr<ushort>(row);
+		uchar *out = depth8.ptr<uchar>(row);
+
+		for (int col = 0; col < depth16.cols; col++, in++, out += 3)
+		{
+			out[0] = *in & 0x00FF;
+			out[1] = *in >> 8;
+			out[2] = 0;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void DepthCamera::convertDepthToMat_16UC1(
 	const xn::DepthMetaData &depthMetaData, cv::Mat &kinectDepthOut)
 {
@@ -301,6 +346,41 @@ void DepthCamera::convertRGBToMat(const xn::ImageMetaData &imageMetaData,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void DepthCamera::trackedSkeletons(SessionSkeletons &skeletons)
+{
+	XnUserID userIDs[15];
+	XnUInt16 numberOfUsers = 15;
+
+	m_userGenerator.GetUsers(userIDs, numberOfUsers);
+
+	skeletons.clear();
+
+	for (XnUInt16 i = 0; i < numberOfUsers; i++)
+	{
+		if (!m_userGenerator.GetSkeletonCap().IsTracking(userIDs[i]))
+			continue;
+
+		SessionSkeleton skeleton;
+		skeleton.userID = userIDs[i];
+
+		for (int joint = 0; joint < SESSION_NUMBER_OF_JOINTS; joint++)
+		{
+			XnSkeletonJointPosition position;
+			m_userGenerator.GetSkeletonCap().GetSkeletonJointPosition(
+				userIDs[i], (XnSkeletonJoint)(XN_SKEL_HEAD + joint), position);
+
+			skeleton.joints[joint].x = position.position.X;
+			skeleton.joints[joint].y = position.position.Y;
+			skeleton.joints[joint].z = position.position.Z;
+			skeleton.joints[joint].confidence = position.fConfidence;
+		}
+
+		skeletons.push_back(skeleton);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void DepthCamera::showSkeleton(cv::Mat &rgbImage, XnUserID userID)
 {
 	drawLimb(rgbImage, userID, XN_SKEL_HEAD, XN_SKEL_NECK);
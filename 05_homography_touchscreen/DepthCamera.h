@@ -20,13 +20,15 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include "FrameSource.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // DepthCamera
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-class DepthCamera
+class DepthCamera : public FrameSource
 {
 	public:
 		static DepthCamera *instance();
@@ -38,7 +40,7 @@ class DepthCamera
 
 	public:
 		DepthCamera();
-		~DepthCamera();
+		virtual ~DepthCamera();
 
 		static const std::string s_sampleXMLPath;
 
@@ -49,6 +51,10 @@ class DepthCamera
 		int frameFromCamera(cv::Mat &rgbImage, cv::Mat &depthImage,
 							int depthType = CV_16UC1);
 
+		// Reads a frame from the camera with the depth as CV_16UC1. Returns
+		// true if reading succeeds.
+		virtual bool readFrame(cv::Mat &rgbImage, cv::Mat &depthImage);
+
 		// Opens RGB and depth video files.
 		bool loadVideo(const std::string &rgbFile,
 					   const std::string &depthFile);
@@ -59,7 +65,7 @@ class DepthCamera
 		bool frameFromVideo(cv::Mat &rgbFile, cv::Mat &depthFile);
 
 		// Reads RGB and depth images from files. The format of the images
-		// depends on the file format.
+		// depends on the file format. Returns true if reading succeeds.
 		static bool frameFromFile(std::string rgbFile, cv::Mat &rgbImage,
 								 std::string depthFile, cv::Mat &depthImage);
 
@@ -69,13 +75,18 @@ class DepthCamera
 		static void convertDepth_8UC3_to_16UC1(const cv::Mat &depth8,
 											   cv::Mat &depth16);
 
+		// Converts a depth image from CV_16UC1 to CV_8UC3 with the high byte
+		// in the green channel and the low byte in the blue channel.
+		static void convertDepth_16UC1_to_8UC3(const cv::Mat &depth16,
+											   cv::Mat &depth8);
+
+		virtual void trackedSkeletons(SessionSkeletons &skeletons);
+
 		// Getters & setters
 		xn::DepthGenerator &depthGenerator();
 		xn::ImageGenerator &imageGenerator();
 		xn::UserGenerator &userGenerator();
 
-		boost::signal<void (XnUserID userID)> onSkeletonTracked;
-
 		// OpenNI skeleton callbacks
 		void User_NewUser(xn::UserGenerator& generator, XnUserID nId, void* pCookie);
 		void User_LostUser(xn::UserGenerator& generator, XnUserID nId, void* pCookie);
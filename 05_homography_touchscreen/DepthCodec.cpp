@@ -0,0 +1,374 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class compressing depth frames losslessly
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "DepthCodec.h"
+
+#include <cstring>
+
+// All x86 processors able to run the Kinect SDK support SSE2
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define DEPTH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// DepthCodec
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const int DepthCodec::s_headerSize = 5;
+
+////////////////////////////////////////////////////////////////////////////////
+
+DepthCodec::DepthCodec(int keyframeInterval)
+{
+	m_keyframeInterval = keyframeInterval;
+	m_framesSinceKeyframe = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::reset()
+{
+	m_previousImage = cv::Mat();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::setKeyframeInterval(int keyframeInterval)
+{
+	m_keyframeInterval = keyframeInterval;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::encode(const cv::Mat &depthImage, std::vector<uchar> &data)
+{
+	bool isKeyframe = m_previousImage.size() != depthImage.size()
+		|| m_framesSinceKeyframe + 1 >= m_keyframeInterval;
+
+	m_residuals.resize(depthImage.total());
+
+	if (isKeyframe)
+	{
+		computeSpatialResiduals(depthImage, &m_residuals[0]);
+		m_framesSinceKeyframe = 0;
+	}
+	else
+	{
+		computeTemporalResiduals(depthImage, m_previousImage, &m_residuals[0]);
+		m_framesSinceKeyframe++;
+	}
+
+	data.push_back(isKeyframe ? FRAME_KEY : FRAME_DELTA);
+	data.push_back(depthImage.cols & 0xFF);
+	data.push_back(depthImage.cols >> 8);
+	data.push_back(depthImage.rows & 0xFF);
+	data.push_back(depthImage.rows >> 8);
+
+	encodeResiduals(&m_residuals[0], m_residuals.size(), data);
+
+	depthImage.copyTo(m_previousImage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool DepthCodec::decode(const uchar *data, std::size_t size,
+						cv::Mat &depthImage)
+{
+	if (size < (std::size_t)s_headerSize)
+		return false;
+
+	int frameType = data[0];
+	int width = data[1] | (data[2] << 8);
+	int height = data[3] | (data[4] << 8);
+
+	if (frameType != FRAME_KEY
+		&& (frameType != FRAME_DELTA
+			|| m_previousImage.size() != cv::Size(width, height)))
+		return false;
+
+	m_residuals.resize(width * height);
+
+	if (m_residuals.empty()
+		|| !decodeResiduals(data + s_headerSize, size - s_headerSize,
+							&m_residuals[0], m_residuals.size()))
+		return false;
+
+	depthImage.create(height, width, CV_16UC1);
+
+	if (frameType == FRAME_KEY)
+		reconstructSpatial(&m_residuals[0], depthImage);
+	else
+		reconstructTemporal(&m_residuals[0], m_previousImage, depthImage);
+
+	depthImage.copyTo(m_previousImage);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::computeSpatialResiduals(const cv::Mat &depthImage,
+										 short *residuals)
+{
+	for (int row = 0; row < depthImage.rows; row++)
+	{
+		const ushort *depth = depthImage.ptr<ushort>(row);
+		short *residual = residuals + row * depthImage.cols;
+
+		// The first pixel of a row is predicted from the pixel above
+		ushort predicted = (row > 0) ? depthImage.ptr<ushort>(row - 1)[0] : 0;
+		residual[0] = (short)(depth[0] - predicted);
+
+		int col = 1;
+
+#ifdef DEPTH_CODEC_SSE2
+		for (; col + 8 <= depthImage.cols; col += 8)
+		{
+			__m128i current = _mm_loadu_si128((const __m128i *)(depth + col));
+			__m128i left = _mm_loadu_si128((const __m128i *)(depth + col - 1));
+			_mm_storeu_si128((__m128i *)(residual + col),
+							 _mm_sub_epi16(current, left));
+		}
+#endif
+
+		for (; col < depthImage.cols; col++)
+			residual[col] = (short)(depth[col] - depth[col - 1]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::computeTemporalResiduals(const cv::Mat &depthImage,
+										  const cv::Mat &previousImage,
+										  short *residuals)
+{
+	for (int row = 0; row < depthImage.rows; row++)
+	{
+		const ushort *depth = depthImage.ptr<ushort>(row);
+		const ushort *previous = previousImage.ptr<ushort>(row);
+		short *residual = residuals + row * depthImage.cols;
+
+		int col = 0;
+
+#ifdef DEPTH_CODEC_SSE2
+		for (; col + 8 <= depthImage.cols; col += 8)
+		{
+			__m128i current = _mm_loadu_si128((const __m128i *)(depth + col));
+			__m128i before = _mm_loadu_si128((const __m128i *)(previous + col));
+			_mm_storeu_si128((__m128i *)(residual + col),
+							 _mm_sub_epi16(current, before));
+		}
+#endif
+
+		for (; col < depthImage.cols; col++)
+			residual[col] = (short)(depth[col] - previous[col]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::reconstructSpatial(const short *residuals,
+									cv::Mat &depthImage)
+{
+	// Each pixel depends on its left neighbor, so this can't be vectorized
+	for (int row = 0; row < depthImage.rows; row++)
+	{
+		ushort *depth = depthImage.ptr<ushort>(row);
+		const short *residual = residuals + row * depthImage.cols;
+
+		ushort predicted = (row > 0) ? depthImage.ptr<ushort>(row - 1)[0] : 0;
+		depth[0] = (ushort)(predicted + residual[0]);
+
+		for (int col = 1; col < depthImage.cols; col++)
+			depth[col] = (ushort)(depth[col - 1] + residual[col]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::reconstructTemporal(const short *residuals,
+									 const cv::Mat &previousImage,
+									 cv::Mat &depthImage)
+{
+	for (int row = 0; row < depthImage.rows; row++)
+	{
+		ushort *depth = depthImage.ptr<ushort>(row);
+		const ushort *previous = previousImage.ptr<ushort>(row);
+		const short *residual = residuals + row * depthImage.cols;
+
+		int col = 0;
+
+#ifdef DEPTH_CODEC_SSE2
+		for (; col + 8 <= depthImage.cols; col += 8)
+		{
+			__m128i before = _mm_loadu_si128((const __m128i *)(previous + col));
+			__m128i delta = _mm_loadu_si128((const __m128i *)(residual + col));
+			_mm_storeu_si128((__m128i *)(depth + col),
+							 _mm_add_epi16(before, delta));
+		}
+#endif
+
+		for (; col < depthImage.cols; col++)
+			depth[col] = (ushort)(previous[col] + residual[col]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int DepthCodec::zeroRunLength(const short *residuals, int count)
+{
+	int length = 0;
+
+#ifdef DEPTH_CODEC_SSE2
+	// Skip eight zeros at once
+	__m128i zero = _mm_setzero_si128();
+
+	for (; length + 8 <= count; length += 8)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i *)(residuals + length));
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(values, zero)) != 0xFFFF)
+			break;
+	}
+#endif
+
+	while (length < count && residuals[length] == 0)
+		length++;
+
+	return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DepthCodec::encodeResiduals(const short *residuals, int count,
+								 std::vector<uchar> &data)
+{
+	int i = 0;
+
+	while (i < count)
+	{
+		int residual = residuals[i];
+
+		if (residual == 0)
+		{
+			int run = zeroRunLength(residuals + i, count - i);
+
+			if (run > 65535 + 128)
+				run = 65535 + 128;
+
+			if (run < 128)
+				data.push_back(run - 1);
+			else
+			{
+				data.push_back(0x7F);
+				data.push_back((run - 128) & 0xFF);
+				data.push_back((run - 128) >> 8);
+			}
+
+			i += run;
+			continue;
+		}
+
+		// Pack two tiny residuals into one byte
+		if (i + 1 < count && residual >= -4 && residual < 4
+			&& residuals[i + 1] >= -4 && residuals[i + 1] < 4)
+		{
+			data.push_back(0x80 | ((residual + 4) << 3)
+						   | (residuals[i + 1] + 4));
+
+			i += 2;
+			continue;
+		}
+
+		if (residual >= -16 && residual < 16)
+			data.push_back(0xC0 | (residual + 16));
+		else if (residual >= -2048 && residual < 2048)
+		{
+			data.push_back(0xE0 | ((residual + 2048) >> 8));
+			data.push_back((residual + 2048) & 0xFF);
+		}
+		else
+		{
+			data.push_back(0xF0);
+			data.push_back((ushort)residual & 0xFF);
+			data.push_back((ushort)residual >> 8);
+		}
+
+		i++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool DepthCodec::decodeResiduals(const uchar *data, std::size_t size,
+								 short *residuals, int count)
+{
+	std::size_t position = 0;
+	int i = 0;
+
+	while (position < size && i < count)
+	{
+		uchar token = data[position++];
+
+		if (token < 0x7F)
+		{
+			int run = token + 1;
+
+			if (run > count - i)
+				return false;
+
+			memset(residuals + i, 0, run * sizeof(short));
+			i += run;
+		}
+		else if (token == 0x7F)
+		{
+			if (position + 2 > size)
+				return false;
+
+			int run = (data[position] | (data[position + 1] << 8)) + 128;
+			position += 2;
+
+			if (run > count - i)
+				return false;
+
+			memset(residuals + i, 0, run * sizeof(short));
+			i += run;
+		}
+		else if (token < 0xC0)
+		{
+			if (i + 2 > count)
+				return false;
+
+			residuals[i++] = ((token >> 3) & 0x07) - 4;
+			residuals[i++] = (token & 0x07) - 4;
+		}
+		else if (token < 0xE0)
+			residuals[i++] = (token & 0x1F) - 16;
+		else if (token < 0xF0)
+		{
+			if (position + 1 > size)
+				return false;
+
+			residuals[i++] = (((token & 0x0F) << 8) | data[position++]) - 2048;
+		}
+		else if (token == 0xF0)
+		{
+			if (position + 2 > size)
+				return false;
+
+			residuals[i++] = (short)(data[position]
+									 | (data[position + 1] << 8));
+			position += 2;
+		}
+		else
+			return false;
+	}
+
+	return i == count && position == size;
+}
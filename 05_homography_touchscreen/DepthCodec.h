@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class compressing depth frames losslessly
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __DEPTH_CODEC_H
+#define __DEPTH_CODEC_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// DepthCodec
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Compresses sequences of CV_16UC1 depth frames. Keyframes predict each pixel
+// from its left neighbor, all other frames predict each pixel from the same
+// pixel in the previous frame. The prediction residuals are stored as a byte
+// stream of tokens:
+//
+// 0xxxxxxx                 x + 1 zeros (x < 127)
+// 01111111 nnnnnnnn nnnnnnnn
+//                          n + 128 zeros (n little endian)
+// 10aaabbb                 two residuals a - 4 and b - 4
+// 110xxxxx                 one residual x - 16
+// 1110xxxx xxxxxxxx        one residual x - 2048 (x big endian)
+// 11110000 rrrrrrrr rrrrrrrr
+//                          one raw 16-bit residual (little endian)
+//
+// Pixels without depth and static parts of the scene yield long zero runs,
+// while the floor and sensor noise yield tiny residuals packed in pairs.
+//
+// Frames must be decoded in the order they have been encoded, starting with a
+// keyframe. Use separate instances for encoding and decoding.
+class DepthCodec
+{
+	public:
+		DepthCodec(int keyframeInterval = 30);
+
+		// Appends the compressed depth image to data
+		void encode(const cv::Mat &depthImage, std::vector<uchar> &data);
+
+		// Decompresses a frame into a CV_16UC1 image. Returns false if the
+		// data is corrupt or a delta frame doesn't match the previous frame.
+		bool decode(const uchar *data, std::size_t size, cv::Mat &depthImage);
+
+		// Makes the next frame encoded a keyframe. Delta frames are rejected
+		// by decode until the next keyframe.
+		void reset();
+
+		// Every n-th frame is encoded as a keyframe
+		void setKeyframeInterval(int keyframeInterval);
+
+	protected:
+		enum {FRAME_KEY = 0, FRAME_DELTA = 1};
+
+		// Size of the frame header (type, width and height)
+		static const int s_headerSize;
+
+		static void computeSpatialResiduals(const cv::Mat &depthImage,
+											short *residuals);
+		static void computeTemporalResiduals(const cv::Mat &depthImage,
+											 const cv::Mat &previousImage,
+											 short *residuals);
+
+		static void reconstructSpatial(const short *residuals,
+									   cv::Mat &depthImage);
+		static void reconstructTemporal(const short *residuals,
+										const cv::Mat &previousImage,
+										cv::Mat &depthImage);
+
+		static void encodeResiduals(const short *residuals, int count,
+									std::vector<uchar> &data);
+		static bool decodeResiduals(const uchar *data, std::size_t size,
+									short *residuals, int count);
+
+		static int zeroRunLength(const short *residuals, int count);
+
+		int m_keyframeInterval;
+		int m_framesSinceKeyframe;
+
+		cv::Mat m_previousImage;
+		std::vector<short> m_residuals;
+};
+
+#endif
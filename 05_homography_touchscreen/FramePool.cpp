@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Recycles the frames passed through the processing pipeline
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FramePool.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// FramePool
+//
+////////////////////////////////////////////////////////////////////////////////
+
+FramePool::FramePool(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+FramePool::~FramePool()
+{
+	for (unsigned int i = 0; i < m_frames.size(); i++)
+		delete m_frames[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Frame *FramePool::acquire()
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	if (!m_freeFrames.empty())
+	{
+		Frame *frame = m_freeFrames.back();
+		m_freeFrames.pop_back();
+
+		frame->isTouching = false;
+
+		return frame;
+	}
+
+	Frame *frame = new Frame;
+	frame->rgbImage = cv::Mat(m_height, m_width, CV_8UC3);
+	frame->depthImage = cv::Mat(m_height, m_width, CV_16UC1);
+	frame->isTouching = false;
+
+	m_frames.push_back(frame);
+
+	return frame;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FramePool::release(Frame *frame)
+{
+	if (!frame)
+		return;
+
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	m_freeFrames.push_back(frame);
+}
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Recycles the frames passed through the processing pipeline
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FRAME_POOL_H
+#define __FRAME_POOL_H
+
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/thread.hpp>
+
+#include <opencv2/core/core.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Frame
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// A camera frame together with the results of the stages it has passed
+struct Frame
+{
+	cv::Mat rgbImage;
+	cv::Mat depthImage;
+
+	// The time the frame has been captured
+	boost::chrono::steady_clock::time_point captureTime;
+
+	// Whether a foot touches the floor and where, in physical coordinates
+	bool isTouching;
+	cv::Point input;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// FramePool
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Hands out frames whose images keep their buffers, so that capturing doesn't
+// allocate once the pipeline is filled. All frames are deleted with the pool.
+class FramePool
+{
+	public:
+		FramePool(int width = 640, int height = 480);
+		~FramePool();
+
+		Frame *acquire();
+		void release(Frame *frame);
+
+	protected:
+		int m_width;
+		int m_height;
+
+		// All frames ever created, and the ones not in use
+		std::vector<Frame*> m_frames;
+		std::vector<Frame*> m_freeFrames;
+
+		boost::mutex m_mutex;
+};
+
+#endif
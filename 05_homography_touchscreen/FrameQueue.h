@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Lock-free queue passing frames between two pipeline stages
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FRAME_QUEUE_H
+#define __FRAME_QUEUE_H
+
+#include "game/Atomic.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// FrameQueue
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Bounded queue between exactly one producer and one consumer thread. Pushing
+// never blocks: if the queue is full, the oldest item is evicted and handed
+// back to the producer, so a slow consumer always gets the most recent items.
+//
+// Both threads claim the oldest item by advancing the read position with a
+// compare-and-swap, so the producer and the consumer never both get the same
+// item. Items have to be copyable without side effects, such as pointers.
+template <class T, int CAPACITY>
+class FrameQueue
+{
+	public:
+		FrameQueue()
+		{
+			m_readPosition = 0;
+			m_writePosition = 0;
+		}
+
+		// Called by the producer only. Returns true if the oldest item had to
+		// be evicted to make room, which is then stored in evicted.
+		bool push(const T &item, T &evicted)
+		{
+			bool hasEvicted = false;
+			long writePosition = m_writePosition;
+			long readPosition = Atomic::load(&m_readPosition);
+
+			if (writePosition - readPosition == CAPACITY)
+			{
+				T oldest = m_items[readPosition % CAPACITY];
+
+				// If this fails, the consumer has just taken the oldest item
+				if (Atomic::compareAndSwap(&m_readPosition, readPosition,
+					readPosition + 1))
+				{
+					evicted = oldest;
+					hasEvicted = true;
+				}
+			}
+
+			m_items[writePosition % CAPACITY] = item;
+			Atomic::store(&m_writePosition, writePosition + 1);
+
+			return hasEvicted;
+		}
+
+		// Called by the consumer only. Returns false if the queue is empty.
+		bool pop(T &item)
+		{
+			while (true)
+			{
+				long readPosition = Atomic::load(&m_readPosition);
+
+				if (readPosition == Atomic::load(&m_writePosition))
+					return false;
+
+				item = m_items[readPosition % CAPACITY];
+
+				// If this fails, the producer has just evicted the item
+				if (Atomic::compareAndSwap(&m_readPosition, readPosition,
+					readPosition + 1))
+					return true;
+			}
+		}
+
+	protected:
+		T m_items[CAPACITY];
+
+		volatile long m_readPosition;
+		volatile long m_writePosition;
+};
+
+#endif
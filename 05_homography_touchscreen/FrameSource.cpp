@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Interface of classes providing RGB and depth frames
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameSource.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// FrameSource
+//
+////////////////////////////////////////////////////////////////////////////////
+
+FrameSource::~FrameSource()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FrameSource::trackedSkeletons(SessionSkeletons &skeletons)
+{
+	skeletons.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool FrameSource::trackedSkeleton(unsigned int userID,
+								  SessionSkeleton &skeleton)
+{
+	SessionSkeletons skeletons;
+	trackedSkeletons(skeletons);
+
+	for (unsigned int i = 0; i < skeletons.size(); i++)
+		if (skeletons[i].userID == userID)
+		{
+			skeleton = skeletons[i];
+			return true;
+		}
+
+	return false;
+}
@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Interface of classes providing RGB and depth frames
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __FRAME_SOURCE_H
+#define __FRAME_SOURCE_H
+
+#include <boost/signal.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "SessionFormat.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// FrameSource
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class FrameSource
+{
+	public:
+		virtual ~FrameSource();
+
+		// Reads the next frame into a CV_8UC3 RGB image and a CV_16UC1 depth
+		// image. Returns true if reading succeeds.
+		virtual bool readFrame(cv::Mat &rgbImage, cv::Mat &depthImage) = 0;
+
+		// Returns the joints of all users whose skeletons are being tracked
+		// in the frame read last. Sources without skeletons return none.
+		virtual void trackedSkeletons(SessionSkeletons &skeletons);
+
+		// Finds the skeleton of one user among the tracked ones. Returns
+		// false if the user is not being tracked.
+		bool trackedSkeleton(unsigned int userID, SessionSkeleton &skeleton);
+
+		// Emitted while reading a frame for each user being tracked in it
+		boost::signal<void (unsigned int userID)> onSkeletonTracked;
+};
+
+#endif
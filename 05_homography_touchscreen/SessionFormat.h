@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// File format of recorded camera sessions
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SESSION_FORMAT_H
+#define __SESSION_FORMAT_H
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+// A session file starts with a SessionFileHeader followed by a sequence of
+// chunks. Each chunk starts with a SessionChunkHeader giving its type and the
+// size of its payload, so that readers can skip chunk types they don't know.
+//
+// The payload of a frame chunk is a SessionFrameHeader followed by the RGB
+// image (CV_8UC3), the depth image (CV_16UC1) and the tracked skeletons. All
+// values are stored in little-endian byte order. Depth images may be
+// compressed with DepthCodec, in which case they must be decoded in order.
+
+// "JNSR" read as a little-endian number
+enum {SESSION_MAGIC = 0x52534E4A};
+enum {SESSION_VERSION = 1};
+
+enum {SESSION_CHUNK_FRAME = 1};
+
+enum {SESSION_COMPRESSION_NONE = 0, SESSION_COMPRESSION_DEPTH_CODEC};
+
+// XN_SKEL_HEAD to XN_SKEL_RIGHT_FOOT
+enum {SESSION_NUMBER_OF_JOINTS = 24};
+
+#pragma pack(push, 1)
+
+struct SessionFileHeader
+{
+	boost::uint32_t magic;
+	boost::uint16_t version;
+	boost::uint16_t numberOfJoints;
+	boost::uint16_t rgbWidth;
+	boost::uint16_t rgbHeight;
+	boost::uint16_t depthWidth;
+	boost::uint16_t depthHeight;
+};
+
+struct SessionChunkHeader
+{
+	boost::uint32_t type;
+	boost::uint32_t size;
+};
+
+struct SessionFrameHeader
+{
+	// Microseconds since the recording has started
+	boost::uint64_t timestamp;
+
+	boost::uint16_t rgbCompression;
+	boost::uint16_t depthCompression;
+
+	// Sizes of the stored image data in bytes
+	boost::uint32_t rgbSize;
+	boost::uint32_t depthSize;
+
+	boost::uint16_t numberOfSkeletons;
+};
+
+struct SessionJoint
+{
+	// Real world position in millimeters
+	float x;
+	float y;
+	float z;
+
+	float confidence;
+};
+
+struct SessionSkeleton
+{
+	boost::uint32_t userID;
+
+	// Indexed by the OpenNI joint number minus one
+	SessionJoint joints[SESSION_NUMBER_OF_JOINTS];
+};
+
+#pragma pack(pop)
+
+typedef std::vector<SessionSkeleton> SessionSkeletons;
+
+#endif
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class recording camera frames into a session file
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SessionRecorder.h"
+
+#include <sstream>
+
+#include "game/Logging.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SessionRecorder
+//
+////////////////////////////////////////////////////////////////////////////////
+
+SessionRecorder::SessionRecorder()
+{
+	m_numberOfFrames = 0;
+	m_isDepthCompressed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SessionRecorder::~SessionRecorder()
+{
+	close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionRecorder::open(const std::string &fileName)
+{
+	close();
+
+	m_file.open(fileName.c_str(), std::ios::out | std::ios::binary
+				| std::ios::trunc);
+
+	if (!m_file.is_open())
+	{
+		Logging::error("Could not create session file " + fileName + ".");
+
+		return false;
+	}
+
+	m_numberOfFrames = 0;
+
+	// The first frame of the file must be a keyframe
+	m_depthCodec.reset();
+
+	Logging::info("Recording session into " + fileName + ".");
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionRecorder::close()
+{
+	if (!m_file.is_open())
+		return;
+
+	m_file.close();
+
+	std::stringstream message;
+	message << "Recorded " << m_numberOfFrames << " frames.";
+	Logging::info(message.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionRecorder::isOpen() const
+{
+	return m_file.is_open();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionRecorder::record(const cv::Mat &rgbImage,
+							 const cv::Mat &depthImage,
+							 const SessionSkeletons &skeletons)
+{
+	if (!m_file.is_open())
+		return;
+
+	// The file header contains the image sizes of the first frame
+	if (m_numberOfFrames == 0)
+	{
+		writeFileHeader(rgbImage, depthImage);
+		m_startTime = boost::chrono::steady_clock::now();
+	}
+
+	if (m_isDepthCompressed)
+	{
+		m_depthData.clear();
+		m_depthCodec.encode(depthImage, m_depthData);
+	}
+
+	SessionFrameHeader frameHeader;
+	frameHeader.timestamp = boost::chrono::duration_cast<
+		boost::chrono::microseconds>(
+			boost::chrono::steady_clock::now() - m_startTime).count();
+	frameHeader.rgbCompression = SESSION_COMPRESSION_NONE;
+	frameHeader.depthCompression = m_isDepthCompressed
+		? SESSION_COMPRESSION_DEPTH_CODEC : SESSION_COMPRESSION_NONE;
+	frameHeader.rgbSize = rgbImage.total() * rgbImage.elemSize();
+	frameHeader.depthSize = m_isDepthCompressed ? m_depthData.size()
+		: depthImage.total() * depthImage.elemSize();
+	frameHeader.numberOfSkeletons = skeletons.size();
+
+	SessionChunkHeader chunkHeader;
+	chunkHeader.type = SESSION_CHUNK_FRAME;
+	chunkHeader.size = sizeof(SessionFrameHeader) + frameHeader.rgbSize
+		+ frameHeader.depthSize + skeletons.size() * sizeof(SessionSkeleton);
+
+	m_file.write((const char *)&chunkHeader, sizeof(SessionChunkHeader));
+	m_file.write((const char *)&frameHeader, sizeof(SessionFrameHeader));
+
+	writeImage(rgbImage);
+
+	if (m_isDepthCompressed)
+		m_file.write((const char *)&m_depthData[0], m_depthData.size());
+	else
+		writeImage(depthImage);
+
+	if (!skeletons.empty())
+		m_file.write((const char *)&skeletons[0],
+					 skeletons.size() * sizeof(SessionSkeleton));
+
+	m_numberOfFrames++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int SessionRecorder::numberOfFrames() const
+{
+	return m_numberOfFrames;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionRecorder::setDepthCompressed(bool isDepthCompressed)
+{
+	// Switching within a file is fine, each frame states its compression
+	m_isDepthCompressed = isDepthCompressed;
+	m_depthCodec.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionRecorder::writeFileHeader(const cv::Mat &rgbImage,
+									  const cv::Mat &depthImage)
+{
+	SessionFileHeader fileHeader;
+	fileHeader.magic = SESSION_MAGIC;
+	fileHeader.version = SESSION_VERSION;
+	fileHeader.numberOfJoints = SESSION_NUMBER_OF_JOINTS;
+	fileHeader.rgbWidth = rgbImage.cols;
+	fileHeader.rgbHeight = rgbImage.rows;
+	fileHeader.depthWidth = depthImage.cols;
+	fileHeader.depthHeight = depthImage.rows;
+
+	m_file.write((const char *)&fileHeader, sizeof(SessionFileHeader));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionRecorder::writeImage(const cv::Mat &image)
+{
+	if (image.isContinuous())
+	{
+		m_file.write((const char *)image.data,
+					 image.total() * image.elemSize());
+
+		return;
+	}
+
+	// Images referring to a region of another image have gaps between rows
+	for (int row = 0; row < image.rows; row++)
+		m_file.write((const char *)image.ptr(row),
+					 image.cols * image.elemSize());
+}
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class recording camera frames into a session file
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SESSION_RECORDER_H
+#define __SESSION_RECORDER_H
+
+#include <fstream>
+#include <string>
+
+#include <boost/chrono.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "DepthCodec.h"
+#include "SessionFormat.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SessionRecorder
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class SessionRecorder
+{
+	public:
+		SessionRecorder();
+		~SessionRecorder();
+
+		// Creates a session file, replacing existing files. Returns true if
+		// the file could be created.
+		bool open(const std::string &fileName);
+		void close();
+
+		bool isOpen() const;
+
+		// Appends a frame to the session file. The RGB image must be CV_8UC3
+		// and the depth image CV_16UC1. All frames must have the size of the
+		// first frame.
+		void record(const cv::Mat &rgbImage, const cv::Mat &depthImage,
+					const SessionSkeletons &skeletons = SessionSkeletons());
+
+		unsigned int numberOfFrames() const;
+
+		// Whether to compress depth images with DepthCodec (default)
+		void setDepthCompressed(bool isDepthCompressed);
+
+	protected:
+		void writeFileHeader(const cv::Mat &rgbImage,
+							 const cv::Mat &depthImage);
+
+		void writeImage(const cv::Mat &image);
+
+		std::ofstream m_file;
+
+		boost::chrono::steady_clock::time_point m_startTime;
+
+		unsigned int m_numberOfFrames;
+
+		bool m_isDepthCompressed;
+		DepthCodec m_depthCodec;
+		std::vector<uchar> m_depthData;
+};
+
+#endif
@@ -0,0 +1,369 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class replaying camera frames from a session file
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SessionReplay.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <boost/thread.hpp>
+
+#include "DepthCamera.h"
+#include "game/Logging.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SessionReplay
+//
+////////////////////////////////////////////////////////////////////////////////
+
+SessionReplay::SessionReplay()
+{
+	m_currentFrame = 0;
+	m_isRealTime = true;
+	m_isLooping = false;
+	m_playbackStartTimestamp = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionReplay::open(const std::string &fileName)
+{
+	close();
+
+	if (!indexFrames(fileName))
+	{
+		Logging::error(fileName + " is no valid session file.");
+
+		close();
+
+		return false;
+	}
+
+	try
+	{
+		boost::interprocess::file_mapping fileMapping(fileName.c_str(),
+			boost::interprocess::read_only);
+
+		m_fileMapping.swap(fileMapping);
+	}
+	catch (boost::interprocess::interprocess_exception &exception)
+	{
+		Logging::error("Could not open session file " + fileName + ": "
+			+ exception.what());
+
+		close();
+
+		return false;
+	}
+
+	std::stringstream message;
+	message << "Replaying " << m_frameChunks.size() << " frames from "
+		<< fileName << ".";
+	Logging::info(message.str());
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::close()
+{
+	boost::interprocess::mapped_region().swap(m_mappedRegion);
+	boost::interprocess::file_mapping().swap(m_fileMapping);
+
+	m_frameChunks.clear();
+	m_skeletons.clear();
+	m_currentFrame = 0;
+	m_depthCodec.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionReplay::isOpen() const
+{
+	return !m_frameChunks.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionReplay::indexFrames(const std::string &fileName)
+{
+	std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+	if (!file.is_open())
+		return false;
+
+	file.seekg(0, std::ios::end);
+	boost::uint64_t size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	if (size < sizeof(SessionFileHeader)
+		|| !file.read((char *)&m_fileHeader, sizeof(SessionFileHeader)))
+		return false;
+
+	if (m_fileHeader.magic != SESSION_MAGIC
+		|| m_fileHeader.version != SESSION_VERSION
+		|| m_fileHeader.numberOfJoints != SESSION_NUMBER_OF_JOINTS)
+		return false;
+
+	// Walk the chunks, a truncated chunk at the end is ignored. Only the
+	// headers are read, the payloads are skipped.
+	boost::uint64_t offset = sizeof(SessionFileHeader);
+
+	while (offset + sizeof(SessionChunkHeader) <= size)
+	{
+		SessionChunkHeader chunkHeader;
+
+		file.seekg(offset);
+
+		if (!file.read((char *)&chunkHeader, sizeof(SessionChunkHeader)))
+			break;
+
+		offset += sizeof(SessionChunkHeader);
+
+		if (chunkHeader.size > size - offset)
+			break;
+
+		if (chunkHeader.type == SESSION_CHUNK_FRAME
+			&& chunkHeader.size >= sizeof(SessionFrameHeader))
+		{
+			SessionFrameHeader frameHeader;
+
+			if (!file.read((char *)&frameHeader, sizeof(SessionFrameHeader)))
+				break;
+
+			// Skip corrupt frames instead of reading past their chunk later
+			if (isComplete(frameHeader, chunkHeader.size))
+			{
+				FrameChunk frameChunk;
+				frameChunk.offset = offset;
+				frameChunk.size = chunkHeader.size;
+
+				m_frameChunks.push_back(frameChunk);
+			}
+		}
+
+		offset += chunkHeader.size;
+	}
+
+	return !m_frameChunks.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionReplay::isComplete(const SessionFrameHeader &frameHeader,
+							   std::size_t chunkSize)
+{
+	// Summed in 64 bit, so that huge sizes cannot wrap around
+	boost::uint64_t frameSize = sizeof(SessionFrameHeader)
+		+ (boost::uint64_t)frameHeader.rgbSize
+		+ (boost::uint64_t)frameHeader.depthSize
+		+ (boost::uint64_t)frameHeader.numberOfSkeletons
+			* sizeof(SessionSkeleton);
+
+	return frameSize <= chunkSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int SessionReplay::frameFromRecording(cv::Mat &rgbImage, cv::Mat &depthImage,
+									  int depthType)
+{
+	if (m_currentFrame >= m_frameChunks.size())
+	{
+		if (!m_isLooping || m_frameChunks.empty())
+			return XN_STATUS_EOF;
+
+		rewind();
+	}
+
+	const FrameChunk &frameChunk = m_frameChunks[m_currentFrame];
+
+	// Map the frame, which unmaps the previous one
+	try
+	{
+		boost::interprocess::mapped_region mappedRegion(m_fileMapping,
+			boost::interprocess::read_only, frameChunk.offset,
+			frameChunk.size);
+
+		m_mappedRegion.swap(mappedRegion);
+	}
+	catch (boost::interprocess::interprocess_exception &exception)
+	{
+		skipFrame((std::string)"Could not map frame of session file: "
+			+ exception.what());
+
+		return XN_STATUS_EOF;
+	}
+
+	const char *frame = (const char *)m_mappedRegion.get_address();
+
+	SessionFrameHeader frameHeader;
+	memcpy(&frameHeader, frame, sizeof(SessionFrameHeader));
+
+	if (!isComplete(frameHeader, frameChunk.size))
+	{
+		skipFrame("Truncated frame in session file.");
+
+		return XN_STATUS_EOF;
+	}
+
+	const char *rgbData = frame + sizeof(SessionFrameHeader);
+	const char *depthData = rgbData + frameHeader.rgbSize;
+	const char *skeletonData = depthData + frameHeader.depthSize;
+
+	boost::uint32_t rgbSize
+		= m_fileHeader.rgbWidth * m_fileHeader.rgbHeight * 3;
+	boost::uint32_t depthSize
+		= m_fileHeader.depthWidth * m_fileHeader.depthHeight * 2;
+
+	bool isDepthCompressed
+		= frameHeader.depthCompression == SESSION_COMPRESSION_DEPTH_CODEC;
+
+	if (frameHeader.rgbCompression != SESSION_COMPRESSION_NONE
+		|| frameHeader.rgbSize != rgbSize
+		|| (!isDepthCompressed
+			&& (frameHeader.depthCompression != SESSION_COMPRESSION_NONE
+				|| frameHeader.depthSize != depthSize)))
+	{
+		skipFrame("Unsupported frame format in session file.");
+
+		return XN_STATUS_EOF;
+	}
+
+	if (m_isRealTime)
+		waitForFrame(frameHeader.timestamp);
+
+	cv::Mat(m_fileHeader.rgbHeight, m_fileHeader.rgbWidth, CV_8UC3,
+			(void *)rgbData).copyTo(rgbImage);
+
+	cv::Mat depth16(m_fileHeader.depthHeight, m_fileHeader.depthWidth,
+					CV_16UC1, (void *)depthData);
+
+	if (isDepthCompressed)
+	{
+		if (!m_depthCodec.decode((const uchar *)depthData,
+								 frameHeader.depthSize, m_decodedDepth))
+		{
+			skipFrame("Corrupt depth frame in session file.");
+
+			return XN_STATUS_EOF;
+		}
+
+		depth16 = m_decodedDepth;
+	}
+
+	if (depthType == CV_16UC1)
+		depth16.copyTo(depthImage);
+	else
+		DepthCamera::convertDepth_16UC1_to_8UC3(depth16, depthImage);
+
+	m_skeletons.resize(frameHeader.numberOfSkeletons);
+
+	if (!m_skeletons.empty())
+		memcpy(&m_skeletons[0], skeletonData,
+			   m_skeletons.size() * sizeof(SessionSkeleton));
+
+	m_currentFrame++;
+
+	// Report the recorded users like the camera reports the tracked ones
+	for (unsigned int i = 0; i < m_skeletons.size(); i++)
+		onSkeletonTracked(m_skeletons[i].userID);
+
+	return XN_STATUS_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::skipFrame(const std::string &reason)
+{
+	Logging::error(reason);
+
+	// The following delta frames refer to the skipped one, so decode nothing
+	// up to the next keyframe instead of applying them to an older frame
+	m_depthCodec.reset();
+
+	m_currentFrame++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::waitForFrame(boost::uint64_t timestamp)
+{
+	boost::chrono::steady_clock::time_point now
+		= boost::chrono::steady_clock::now();
+
+	// Synchronize the first frame played with the current time
+	if (m_currentFrame == 0 || timestamp < m_playbackStartTimestamp)
+	{
+		m_playbackStartTime = now;
+		m_playbackStartTimestamp = timestamp;
+
+		return;
+	}
+
+	boost::int64_t elapsed = boost::chrono::duration_cast<
+		boost::chrono::microseconds>(now - m_playbackStartTime).count();
+	boost::int64_t due = timestamp - m_playbackStartTimestamp;
+
+	if (due > elapsed)
+		boost::this_thread::sleep(boost::posix_time::microseconds(
+			due - elapsed));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SessionReplay::readFrame(cv::Mat &rgbImage, cv::Mat &depthImage)
+{
+	return frameFromRecording(rgbImage, depthImage, CV_16UC1) == XN_STATUS_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const SessionSkeletons &SessionReplay::skeletons() const
+{
+	return m_skeletons;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::trackedSkeletons(SessionSkeletons &skeletons)
+{
+	skeletons = m_skeletons;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::setRealTime(bool isRealTime)
+{
+	m_isRealTime = isRealTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::setLooping(bool isLooping)
+{
+	m_isLooping = isLooping;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SessionReplay::rewind()
+{
+	m_currentFrame = 0;
+
+	// The first frame is a keyframe, but the last one decoded is not
+	m_depthCodec.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int SessionReplay::numberOfFrames() const
+{
+	return m_frameChunks.size();
+}
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class replaying camera frames from a session file
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SESSION_REPLAY_H
+#define __SESSION_REPLAY_H
+
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "DepthCodec.h"
+#include "FrameSource.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SessionReplay
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class SessionReplay : public FrameSource
+{
+	public:
+		SessionReplay();
+
+		// Indexes the frames of a session file, which are mapped into memory
+		// one at a time while replaying. Returns true if the file is a valid
+		// session file.
+		bool open(const std::string &fileName);
+		void close();
+
+		bool isOpen() const;
+
+		// Reads the next recorded frame. Works like
+		// DepthCamera::frameFromCamera and returns XN_STATUS_OK on success or
+		// XN_STATUS_EOF after the last frame if not looping.
+		int frameFromRecording(cv::Mat &rgbImage, cv::Mat &depthImage,
+							   int depthType = CV_16UC1);
+
+		// Reads the next recorded frame with the depth as CV_16UC1. Returns
+		// true if reading succeeds.
+		virtual bool readFrame(cv::Mat &rgbImage, cv::Mat &depthImage);
+
+		// The skeletons tracked in the frame read last
+		const SessionSkeletons &skeletons() const;
+		virtual void trackedSkeletons(SessionSkeletons &skeletons);
+
+		// If enabled, frames are delivered at the recorded frame rate.
+		// Otherwise, they are delivered as fast as they are read.
+		void setRealTime(bool isRealTime);
+
+		// If enabled, the replay starts over after the last frame.
+		void setLooping(bool isLooping);
+
+		void rewind();
+
+		unsigned int numberOfFrames() const;
+
+	protected:
+		bool indexFrames(const std::string &fileName);
+
+		// Steps over a frame which cannot be read, along with the frames
+		// depending on it
+		void skipFrame(const std::string &reason);
+
+		void waitForFrame(boost::uint64_t timestamp);
+
+		// Only the frame read last is mapped, since 32-bit processes lack the
+		// address space for recordings longer than a minute
+		boost::interprocess::file_mapping m_fileMapping;
+		boost::interprocess::mapped_region m_mappedRegion;
+
+		SessionFileHeader m_fileHeader;
+
+		// Offset and size of a frame chunk payload in the file
+		struct FrameChunk
+		{
+			boost::uint64_t offset;
+			std::size_t size;
+		};
+
+		// Whether the payloads of the frame fit into its chunk
+		static bool isComplete(const SessionFrameHeader &frameHeader,
+							   std::size_t chunkSize);
+
+		std::vector<FrameChunk> m_frameChunks;
+		unsigned int m_currentFrame;
+
+		SessionSkeletons m_skeletons;
+
+		DepthCodec m_depthCodec;
+		cv::Mat m_decodedDepth;
+
+		bool m_isRealTime;
+		bool m_isLooping;
+
+		// Start of the playback and timestamp of the first frame played
+		boost::chrono::steady_clock::time_point m_playbackStartTime;
+		boost::uint64_t m_playbackStartTimestamp;
+};
+
+#endif
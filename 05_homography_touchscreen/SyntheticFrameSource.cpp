@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class generating frames of a foot moving on the floor
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "SyntheticFrameSource.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#include <boost/thread.hpp>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SyntheticFrameSource
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const int SyntheticFrameSource::s_floorDepth = 900;
+const int SyntheticFrameSource::s_footHeight = 60;
+
+////////////////////////////////////////////////////////////////////////////////
+
+SyntheticFrameSource::SyntheticFrameSource(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_frameNumber = 0;
+	m_isRealTime = true;
+	m_nextFrameTime = boost::chrono::steady_clock::now();
+
+	// The floor gets farther away towards the top of the image
+	m_floorDepth = cv::Mat(height, width, CV_16UC1);
+
+	for (int row = 0; row < height; row++)
+		m_floorDepth.row(row).setTo(cv::Scalar(floorDepth(row)));
+
+	m_floorRGB = cv::Mat(height, width, CV_8UC3, cv::Scalar(96, 96, 96));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SyntheticFrameSource::readFrame(cv::Mat &rgbImage, cv::Mat &depthImage)
+{
+	if (m_isRealTime)
+	{
+		boost::chrono::steady_clock::time_point now
+			= boost::chrono::steady_clock::now();
+
+		if (m_nextFrameTime > now)
+			boost::this_thread::sleep(boost::posix_time::microseconds(
+				boost::chrono::duration_cast<boost::chrono::microseconds>(
+				m_nextFrameTime - now).count()));
+		else
+			m_nextFrameTime = now;
+
+		m_nextFrameTime += boost::chrono::microseconds(33333);
+	}
+
+	// Move along a Lissajous figure, taking about ten seconds at 30 FPS
+	double phase = 2 * M_PI * (m_frameNumber % 300) / 300.0;
+
+	m_footPosition = cv::Point(
+		m_width / 2 + (int)(m_width / 3 * sin(phase)),
+		m_height / 2 + (int)(m_height / 3 * sin(2 * phase)));
+
+	double footAngle = phase * 180.0 / M_PI;
+	cv::Size footSize(40, 18);
+
+	m_floorDepth.copyTo(depthImage);
+	m_floorRGB.copyTo(rgbImage);
+
+	// The foot is closer to the camera than the floor below it
+	int footDepth = floorDepth(m_footPosition.y) - s_footHeight;
+
+	cv::ellipse(depthImage, m_footPosition, footSize, footAngle, 0, 360,
+				cv::Scalar(footDepth), CV_FILLED);
+	cv::ellipse(rgbImage, m_footPosition, footSize, footAngle, 0, 360,
+				cv::Scalar(32, 48, 160), CV_FILLED);
+
+	m_frameNumber++;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int SyntheticFrameSource::floorDepth(int row) const
+{
+	// Rises by 160 mm over 480 rows, staying below the detector's limit
+	return s_floorDepth + (m_height - row) / 3;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Point SyntheticFrameSource::footPosition() const
+{
+	return m_footPosition;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SyntheticFrameSource::setRealTime(bool isRealTime)
+{
+	m_isRealTime = isRealTime;
+}
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class generating frames of a foot moving on the floor
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SYNTHETIC_FRAME_SOURCE_H
+#define __SYNTHETIC_FRAME_SOURCE_H
+
+#include <boost/chrono.hpp>
+
+#include "FrameSource.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SyntheticFrameSource
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Renders a slightly tilted floor plane and a foot touching it. The foot moves
+// along a fixed path, so that each run produces the same sequence of frames.
+// Used to run the touch detection without a depth camera.
+class SyntheticFrameSource : public FrameSource
+{
+	public:
+		SyntheticFrameSource(int width = 640, int height = 480);
+
+		virtual bool readFrame(cv::Mat &rgbImage, cv::Mat &depthImage);
+
+		// The position of the foot in the frame read last
+		cv::Point footPosition() const;
+
+		// If enabled, frames are delivered at 30 FPS like a depth camera.
+		// Otherwise, they are delivered as fast as they are read.
+		void setRealTime(bool isRealTime);
+
+	protected:
+		int floorDepth(int row) const;
+
+		// Distance of the floor to the camera in millimeters at the bottom of
+		// the image. TouchDetector scales depth to 8 bits, which saturates at
+		// about 1328 mm, so the whole floor has to stay closer than that.
+		static const int s_floorDepth;
+
+		// Height of the foot above the floor in millimeters
+		static const int s_footHeight;
+
+		int m_width;
+		int m_height;
+
+		cv::Mat m_floorDepth;
+		cv::Mat m_floorRGB;
+
+		unsigned int m_frameNumber;
+		cv::Point m_footPosition;
+
+		bool m_isRealTime;
+
+		// The time the next frame is due if delivered in real time
+		boost::chrono::steady_clock::time_point m_nextFrameTime;
+};
+
+#endif
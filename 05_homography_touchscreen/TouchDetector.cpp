@@ -0,0 +1,649 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class recognizing feet touching the floor in depth images
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "TouchDetector.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <boost/bind.hpp>
+
+#include "game/ThreadPool.h"
+
+// All x86 processors able to run the Kinect SDK support SSE2
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define TOUCH_DETECTOR_SSE2
+#include <emmintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TouchDetector
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const unsigned int TouchDetector::s_minContourLength = 100;
+const int TouchDetector::s_minStripeHeight = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+
+TouchDetector::TouchDetector()
+{
+	m_threadPool = NULL;
+	m_downsamplingFactor = 4;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::setThreadPool(ThreadPool *threadPool)
+{
+	m_threadPool = threadPool;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::setPlayArea(const std::vector<cv::Point2f> &polygon,
+								cv::Size frameSize)
+{
+	std::vector<cv::Point> corners;
+
+	for (unsigned int i = 0; i < polygon.size(); i++)
+		corners.push_back(cv::Point(cvRound(polygon[i].x),
+			cvRound(polygon[i].y)));
+
+	cv::Rect frame(cv::Point(0, 0), frameSize);
+
+	m_region = frame;
+
+	if (corners.size() >= 3)
+		m_region = cv::boundingRect(corners) & frame;
+
+	// Without a usable polygon, detect touch in the whole frame
+	if (corners.size() < 3 || m_region.area() == 0)
+	{
+		m_region = frame;
+		m_mask = cv::Mat(frameSize, CV_8UC1, cv::Scalar(255));
+	}
+	else
+	{
+		for (unsigned int i = 0; i < corners.size(); i++)
+			corners[i] -= m_region.tl();
+
+		m_mask = cv::Mat::zeros(m_region.size(), CV_8UC1);
+		cv::fillConvexPoly(m_mask, corners, cv::Scalar(255));
+	}
+
+	m_depthBackground.release();
+	m_background.release();
+	updateCoarseImages();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::setBackground(const cv::Mat &depthImage)
+{
+	depthImage(m_region).copyTo(m_depthBackground);
+	convert(m_depthBackground, m_background);
+	updateCoarseImages();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TouchDetector::hasBackground() const
+{
+	return !m_background.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::setDownsamplingFactor(int downsamplingFactor)
+{
+	if (downsamplingFactor != 1 && downsamplingFactor != 2
+		&& downsamplingFactor != 4)
+		return;
+
+	m_downsamplingFactor = downsamplingFactor;
+	updateCoarseImages();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int TouchDetector::downsamplingFactor() const
+{
+	return m_downsamplingFactor;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::updateCoarseImages()
+{
+	m_coarseMask.release();
+	m_coarseBackground.release();
+
+	if (m_downsamplingFactor == 1)
+		return;
+
+	if (!m_mask.empty())
+	{
+		cv::Size coarseSize(m_mask.cols / m_downsamplingFactor,
+			m_mask.rows / m_downsamplingFactor);
+
+		cv::resize(m_mask, m_coarseMask, coarseSize, 0, 0, cv::INTER_NEAREST);
+	}
+
+	if (!m_depthBackground.empty())
+	{
+		downsample(m_depthBackground, m_coarseDepth, m_downsamplingFactor);
+		convert(m_coarseDepth, m_coarseBackground);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TouchDetector::detect(const cv::Mat &depthImage, cv::RotatedRect &foot)
+{
+	if (m_mask.empty())
+		setPlayArea(std::vector<cv::Point2f>(), depthImage.size());
+
+	if (!hasBackground())
+		return false;
+
+	if (m_downsamplingFactor > 1)
+		return detectCoarseToFine(depthImage, foot);
+
+	return detectFull(depthImage, foot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TouchDetector::detectFull(const cv::Mat &depthImage, cv::RotatedRect &foot)
+{
+	labelComponents(depthImage(m_region), 1);
+
+	if (m_components.empty())
+		return false;
+
+	// Trace the outline of the largest component only
+	const Component *largest = &m_components[0];
+
+	for (unsigned int i = 1; i < m_components.size(); i++)
+		if (m_components[i].area > largest->area)
+			largest = &m_components[i];
+
+	cv::Mat componentImage = cv::Mat::zeros(largest->bounds.size(), CV_8UC1);
+
+	for (unsigned int i = 0; i < m_runs.size(); i++)
+	{
+		const Run &run = m_runs[i];
+
+		if (findRoot(m_parents, i) != largest->root)
+			continue;
+
+		uchar *row = componentImage.ptr(run.row - largest->bounds.y);
+		std::fill(row + run.begin - largest->bounds.x,
+			row + run.end - largest->bounds.x, 255);
+	}
+
+	m_contours.clear();
+	cv::findContours(componentImage, m_contours, CV_RETR_EXTERNAL,
+		CV_CHAIN_APPROX_NONE, m_region.tl() + largest->bounds.tl());
+
+	int index = largestContour(m_contours);
+
+	// Small contours are probably just noise
+	if (index < 0 || m_contours[index].size() <= s_minContourLength)
+		return false;
+
+	foot = cv::fitEllipse(m_contours[index]);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TouchDetector::detectCoarseToFine(const cv::Mat &depthImage,
+									   cv::RotatedRect &foot)
+{
+	const int factor = m_downsamplingFactor;
+	const cv::Mat depthRegion = depthImage(m_region);
+
+	labelComponents(depthRegion, factor);
+
+	if (m_components.empty())
+		return false;
+
+	// Refine the largest candidates, ordered by their area
+	std::vector<std::pair<int, int> > candidates;
+
+	for (unsigned int i = 0; i < m_components.size(); i++)
+		candidates.push_back(std::make_pair(m_components[i].area, (int)i));
+
+	std::sort(candidates.rbegin(), candidates.rend());
+
+	if (candidates.size() > MAX_CANDIDATES)
+		candidates.resize(MAX_CANDIDATES);
+
+	std::vector<cv::Rect> windows;
+
+	for (unsigned int i = 0; i < candidates.size(); i++)
+	{
+		const cv::Rect &bounds = m_components[candidates[i].second].bounds;
+
+		// Pixels next to the leg may have been lost by the reduction, so add
+		// a margin of two coarse pixels
+		cv::Rect window((bounds.x - 2) * factor, (bounds.y - 2) * factor,
+			(bounds.width + 4) * factor, (bounds.height + 4) * factor);
+
+		windows.push_back(window & cv::Rect(cv::Point(0, 0), m_region.size()));
+	}
+
+	std::vector<cv::Point> bestContour;
+	double bestContourArea = 0.0;
+
+	for (unsigned int i = 0; i < windows.size(); i++)
+	{
+		const cv::Rect &window = windows[i];
+
+		if (window.area() == 0)
+			continue;
+
+		segment(depthRegion(window), m_background(window), m_mask(window),
+			m_windowForeground);
+
+		m_contours.clear();
+		cv::findContours(m_windowForeground, m_contours, CV_RETR_EXTERNAL,
+			CV_CHAIN_APPROX_NONE, m_region.tl() + window.tl());
+
+		int index = largestContour(m_contours);
+
+		if (index < 0)
+			continue;
+
+		double area = cv::contourArea(m_contours[index]);
+
+		if (area > bestContourArea)
+		{
+			bestContourArea = area;
+			bestContour.swap(m_contours[index]);
+		}
+	}
+
+	// Small contours are probably just noise
+	if (bestContour.size() <= s_minContourLength)
+		return false;
+
+	foot = cv::fitEllipse(bestContour);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::labelComponents(const cv::Mat &depthRegion, int factor)
+{
+	const cv::Mat &mask = (factor > 1) ? m_coarseMask : m_mask;
+
+	m_foreground.create(mask.size(), CV_8UC1);
+
+	if (factor > 1)
+		m_coarseDepth.create(mask.size(), CV_16UC1);
+
+	// Split the image into horizontal stripes, a few per thread so that
+	// stealing can balance uneven stripes
+	unsigned int numberOfThreads
+		= m_threadPool ? m_threadPool->numberOfThreads() : 1;
+	int numberOfStripes = std::min<int>(2 * numberOfThreads,
+		mask.rows / s_minStripeHeight);
+	numberOfStripes = std::max(1, numberOfStripes);
+
+	m_stripes.resize(numberOfStripes);
+
+	for (int i = 0; i < numberOfStripes; i++)
+	{
+		m_stripes[i].beginRow = i * mask.rows / numberOfStripes;
+		m_stripes[i].endRow = (i + 1) * mask.rows / numberOfStripes;
+	}
+
+	ThreadPool::RangeTask task = boost::bind(&TouchDetector::processStripes,
+		this, boost::cref(depthRegion), factor, _1, _2);
+
+	if (m_threadPool)
+		m_threadPool->parallelFor(0, numberOfStripes, 1, task);
+	else
+		task(0, numberOfStripes);
+
+	mergeStripes();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::processStripes(const cv::Mat &depthRegion, int factor,
+								   int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Stripe &stripe = m_stripes[i];
+		cv::Range rows(stripe.beginRow, stripe.endRow);
+		cv::Mat foreground = m_foreground.rowRange(rows.start, rows.end);
+
+		if (factor > 1)
+		{
+			cv::Mat coarseDepth = m_coarseDepth.rowRange(rows.start, rows.end);
+			downsample(depthRegion.rowRange(rows.start * factor,
+				rows.end * factor), coarseDepth, factor);
+
+			segment(coarseDepth, m_coarseBackground.rowRange(rows.start,
+				rows.end), m_coarseMask.rowRange(rows.start, rows.end),
+				foreground);
+		}
+		else
+			segment(depthRegion.rowRange(rows.start, rows.end),
+				m_background.rowRange(rows.start, rows.end),
+				m_mask.rowRange(rows.start, rows.end), foreground);
+
+		labelRuns(foreground, stripe);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::labelRuns(const cv::Mat &foreground, Stripe &stripe)
+{
+	stripe.runs.clear();
+	stripe.parents.clear();
+
+	// Runs of the previous row
+	int previousBegin = 0;
+	int previousEnd = 0;
+
+	for (int y = 0; y < foreground.rows; y++)
+	{
+		const uchar *row = foreground.ptr(y);
+		int rowBegin = stripe.runs.size();
+
+		for (int x = 0; x < foreground.cols; )
+		{
+			if (!row[x])
+			{
+				x++;
+				continue;
+			}
+
+			Run run;
+			run.row = stripe.beginRow + y;
+			run.begin = x;
+
+			while (x < foreground.cols && row[x])
+				x++;
+
+			run.end = x;
+
+			int index = stripe.runs.size();
+			stripe.runs.push_back(run);
+			stripe.parents.push_back(index);
+
+			// Join runs of the previous row touching this one, including
+			// diagonally
+			for (int j = previousBegin; j < previousEnd; j++)
+			{
+				const Run &previous = stripe.runs[j];
+
+				if (previous.end < run.begin)
+					continue;
+
+				if (previous.begin > run.end)
+					break;
+
+				unite(stripe.parents, index, j);
+			}
+		}
+
+		previousBegin = rowBegin;
+		previousEnd = stripe.runs.size();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::mergeStripes()
+{
+	m_runs.clear();
+	m_parents.clear();
+
+	std::vector<int> offsets;
+
+	for (unsigned int i = 0; i < m_stripes.size(); i++)
+	{
+		Stripe &stripe = m_stripes[i];
+		int offset = m_runs.size();
+		offsets.push_back(offset);
+
+		m_runs.insert(m_runs.end(), stripe.runs.begin(), stripe.runs.end());
+
+		for (unsigned int j = 0; j < stripe.parents.size(); j++)
+			m_parents.push_back(offset + findRoot(stripe.parents, j));
+	}
+
+	// Join touching runs across the stripe borders. Runs are sorted by row
+	// and column, so both border rows are scanned once.
+	for (unsigned int i = 1; i < m_stripes.size(); i++)
+	{
+		int upperRow = m_stripes[i].beginRow - 1;
+		int lowerRow = m_stripes[i].beginRow;
+
+		int upper = offsets[i];
+		int upperBegin = upper;
+
+		while (upperBegin > offsets[i - 1] && m_runs[upperBegin - 1].row == upperRow)
+			upperBegin--;
+
+		int lowerEnd = offsets[i];
+
+		while (lowerEnd < (int)m_runs.size() && m_runs[lowerEnd].row == lowerRow)
+			lowerEnd++;
+
+		int j = upperBegin;
+
+		for (int k = offsets[i]; k < lowerEnd; k++)
+		{
+			const Run &lower = m_runs[k];
+
+			// Skip the upper runs ending left of this one
+			while (j < upper && m_runs[j].end < lower.begin)
+				j++;
+
+			for (int l = j; l < upper && m_runs[l].begin <= lower.end; l++)
+				unite(m_parents, k, l);
+		}
+	}
+
+	// Collect the size and the bounding box of each component
+	m_components.clear();
+	std::vector<int> componentIndices(m_runs.size(), -1);
+
+	for (unsigned int i = 0; i < m_runs.size(); i++)
+	{
+		const Run &run = m_runs[i];
+		int root = findRoot(m_parents, i);
+		cv::Rect bounds(run.begin, run.row, run.end - run.begin, 1);
+
+		if (componentIndices[root] < 0)
+		{
+			componentIndices[root] = m_components.size();
+
+			Component component;
+			component.root = root;
+			component.area = 0;
+			component.bounds = bounds;
+			m_components.push_back(component);
+		}
+
+		Component &component = m_components[componentIndices[root]];
+		component.area += run.end - run.begin;
+		component.bounds |= bounds;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int TouchDetector::findRoot(std::vector<int> &parents, int index)
+{
+	while (parents[index] != index)
+	{
+		// Path halving
+		parents[index] = parents[parents[index]];
+		index = parents[index];
+	}
+
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::unite(std::vector<int> &parents, int first, int second)
+{
+	first = findRoot(parents, first);
+	second = findRoot(parents, second);
+
+	// The smaller index becomes the root, which keeps roots of runs within
+	// their stripe
+	if (first < second)
+		parents[second] = first;
+	else if (second < first)
+		parents[first] = second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::downsampleMin(const cv::Mat &depthImage, cv::Mat &result)
+{
+	result.create(depthImage.rows / 2, depthImage.cols / 2, CV_16UC1);
+
+	for (int y = 0; y < result.rows; y++)
+	{
+		const ushort *row0 = depthImage.ptr<ushort>(2 * y);
+		const ushort *row1 = depthImage.ptr<ushort>(2 * y + 1);
+		ushort *output = result.ptr<ushort>(y);
+
+		int x = 0;
+
+#ifdef TOUCH_DETECTOR_SSE2
+		// SSE2 lacks an unsigned 16-bit minimum. Subtracting 1 turns invalid
+		// pixels into the largest value, and flipping the sign bit maps the
+		// unsigned order onto the signed one.
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i sign = _mm_set1_epi16((short)0x8000);
+
+		for (; x + 8 <= result.cols; x += 8)
+		{
+			__m128i a0 = _mm_loadu_si128((const __m128i *)(row0 + 2 * x));
+			__m128i a1 = _mm_loadu_si128((const __m128i *)(row0 + 2 * x + 8));
+			__m128i b0 = _mm_loadu_si128((const __m128i *)(row1 + 2 * x));
+			__m128i b1 = _mm_loadu_si128((const __m128i *)(row1 + 2 * x + 8));
+
+			a0 = _mm_xor_si128(_mm_sub_epi16(a0, one), sign);
+			a1 = _mm_xor_si128(_mm_sub_epi16(a1, one), sign);
+			b0 = _mm_xor_si128(_mm_sub_epi16(b0, one), sign);
+			b1 = _mm_xor_si128(_mm_sub_epi16(b1, one), sign);
+
+			// Vertical minimum
+			__m128i v0 = _mm_min_epi16(a0, b0);
+			__m128i v1 = _mm_min_epi16(a1, b1);
+
+			// Horizontal minimum, the results end up in the even lanes
+			v0 = _mm_min_epi16(v0, _mm_srli_epi32(v0, 16));
+			v1 = _mm_min_epi16(v1, _mm_srli_epi32(v1, 16));
+
+			// Sign-extend the even lanes so that packing doesn't saturate
+			v0 = _mm_srai_epi32(_mm_slli_epi32(v0, 16), 16);
+			v1 = _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16);
+
+			__m128i packed = _mm_packs_epi32(v0, v1);
+			packed = _mm_add_epi16(_mm_xor_si128(packed, sign), one);
+
+			_mm_storeu_si128((__m128i *)(output + x), packed);
+		}
+#endif
+
+		for (; x < result.cols; x++)
+		{
+			ushort a = std::min((ushort)(row0[2 * x] - 1),
+				(ushort)(row0[2 * x + 1] - 1));
+			ushort b = std::min((ushort)(row1[2 * x] - 1),
+				(ushort)(row1[2 * x + 1] - 1));
+
+			output[x] = (ushort)(std::min(a, b) + 1);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::downsample(const cv::Mat &depthImage, cv::Mat &result,
+							   int factor)
+{
+	if (factor == 4)
+	{
+		cv::Mat half;
+		downsampleMin(depthImage, half);
+		downsampleMin(half, result);
+	}
+	else if (factor == 2)
+		downsampleMin(depthImage, result);
+	else
+		depthImage.copyTo(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::convert(const cv::Mat &depthImage, cv::Mat &result)
+{
+	// Brighten up the depth image by 32 and convert it to 8 bit, both
+	// saturate at the same depth
+	depthImage.convertTo(result, CV_8UC1, 32 * 0.006, 0); // very important magic number
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TouchDetector::segment(const cv::Mat &depthImage,
+							const cv::Mat &background, const cv::Mat &mask,
+							cv::Mat &foreground)
+{
+	convert(depthImage, foreground);
+
+	// Remove the floor from the image and lighten it up
+	cv::absdiff(background, foreground, foreground);
+	foreground *= 2;
+
+	// Keep everything slightly above the floor, which are feet touching it
+	cv::threshold(foreground, foreground, 50, 0, cv::THRESH_TOZERO_INV);
+	cv::threshold(foreground, foreground, 10, 0, cv::THRESH_TOZERO);
+
+	// Ignore everything outside of the play area
+	cv::bitwise_and(foreground, mask, foreground);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int TouchDetector::largestContour(
+	const std::vector<std::vector<cv::Point> > &contours)
+{
+	double maxContourArea = 0.0;
+	int maxContourIndex = -1;
+
+	for (unsigned int i = 0; i < contours.size(); i++)
+	{
+		double contourArea = cv::contourArea(contours[i]);
+
+		if (contourArea > maxContourArea)
+		{
+			maxContourArea = contourArea;
+			maxContourIndex = i;
+		}
+	}
+
+	return maxContourIndex;
+}
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Class recognizing feet touching the floor in depth images
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __TOUCH_DETECTOR_H
+#define __TOUCH_DETECTOR_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+class ThreadPool;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TouchDetector
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Segments everything slightly above the empty floor and fits an ellipse to
+// the largest blob. Detection is restricted to the play area.
+//
+// With a downsampling factor of 2 or 4, candidate blobs are searched in a
+// depth image reduced by that factor first. Each pixel of the reduced image is
+// the minimal valid depth of the pixels it covers, so thin objects close to
+// the floor survive the reduction. Only windows around the candidates are then
+// segmented at full resolution, so the resulting ellipse is just as accurate.
+//
+// Segmentation and connected-component labelling run on horizontal stripes in
+// parallel if a thread pool is set. The components are then merged across the
+// stripe borders.
+class TouchDetector
+{
+	public:
+		TouchDetector();
+
+		// Processes stripes of the depth image on the pool, which has to
+		// outlive the detector. Without a pool, everything runs serially.
+		void setThreadPool(ThreadPool *threadPool);
+
+		// Restricts detection to a polygon given in depth image coordinates.
+		// The background has to be captured again afterwards.
+		void setPlayArea(const std::vector<cv::Point2f> &polygon,
+						 cv::Size frameSize);
+
+		// Captures the depth image of the empty floor
+		void setBackground(const cv::Mat &depthImage);
+		bool hasBackground() const;
+
+		// 1 searches at full resolution only, 2 or 4 search coarse to fine
+		void setDownsamplingFactor(int downsamplingFactor);
+		int downsamplingFactor() const;
+
+		// Finds the largest foot touching the floor in a CV_16UC1 depth image.
+		// Returns false if there is none.
+		bool detect(const cv::Mat &depthImage, cv::RotatedRect &foot);
+
+	protected:
+		// At most this many coarse blobs are refined at full resolution
+		enum {MAX_CANDIDATES = 4};
+
+		// Contours with fewer points are considered noise
+		static const unsigned int s_minContourLength;
+
+		// Stripes are at least this many rows high
+		static const int s_minStripeHeight;
+
+		// Horizontal run of foreground pixels [begin, end) in a row
+		struct Run
+		{
+			int row;
+			int begin;
+			int end;
+		};
+
+		// Rows [beginRow, endRow) labelled by one task. The runs are sorted by
+		// row and column, and the parents form a union-find forest over them.
+		struct Stripe
+		{
+			int beginRow;
+			int endRow;
+			std::vector<Run> runs;
+			std::vector<int> parents;
+		};
+
+		// Connected set of runs, identified by the root of its tree
+		struct Component
+		{
+			int root;
+			int area;
+			cv::Rect bounds;
+		};
+
+		// Halves both dimensions taking the minimal nonzero depth of each 2x2
+		// block, or 0 if the whole block is invalid
+		static void downsampleMin(const cv::Mat &depthImage, cv::Mat &result);
+		static void downsample(const cv::Mat &depthImage, cv::Mat &result,
+							   int factor);
+
+		// Converts the depth image to 8 bit
+		static void convert(const cv::Mat &depthImage, cv::Mat &result);
+
+		// Marks pixels slightly above the background inside the mask
+		static void segment(const cv::Mat &depthImage,
+							const cv::Mat &background, const cv::Mat &mask,
+							cv::Mat &foreground);
+
+		// Returns the index of the contour with the largest area or -1
+		static int largestContour(
+			const std::vector<std::vector<cv::Point> > &contours);
+
+		// Reduces the mask and the background to the downsampling factor
+		void updateCoarseImages();
+
+		// Segments the play area at the given downsampling factor and finds
+		// its connected components
+		void labelComponents(const cv::Mat &depthRegion, int factor);
+		void processStripes(const cv::Mat &depthRegion, int factor,
+							int begin, int end);
+		static void labelRuns(const cv::Mat &foreground, Stripe &stripe);
+		void mergeStripes();
+
+		static int findRoot(std::vector<int> &parents, int index);
+		static void unite(std::vector<int> &parents, int first, int second);
+
+		bool detectFull(const cv::Mat &depthImage, cv::RotatedRect &foot);
+		bool detectCoarseToFine(const cv::Mat &depthImage,
+								cv::RotatedRect &foot);
+
+		ThreadPool *m_threadPool;
+
+		int m_downsamplingFactor;
+
+		// The bounding box of the play area and the mask of the play area
+		// within it, at full and at reduced resolution
+		cv::Rect m_region;
+		cv::Mat m_mask;
+		cv::Mat m_coarseMask;
+
+		// The background inside the bounding box, in depth and converted to
+		// 8 bit at full and at reduced resolution
+		cv::Mat m_depthBackground;
+		cv::Mat m_background;
+		cv::Mat m_coarseBackground;
+
+		// Buffers reused across frames
+		cv::Mat m_coarseDepth;
+		cv::Mat m_foreground;
+		cv::Mat m_windowForeground;
+		std::vector<std::vector<cv::Point> > m_contours;
+
+		// The labelling of the last frame, with runs and parents of all
+		// stripes concatenated
+		std::vector<Stripe> m_stripes;
+		std::vector<Run> m_runs;
+		std::vector<int> m_parents;
+		std::vector<Component> m_components;
+};
+
+#endif
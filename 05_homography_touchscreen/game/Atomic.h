@@ -0,0 +1,124 @@
+#ifndef __GENERAL_ATOMIC_H
+#define __GENERAL_ATOMIC_H
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @class Atomic
+ *
+ * @brief Atomic operations on 32-bit integers.
+ *
+ * Wraps the compiler intrinsics, because neither the standard library nor
+ * boost provide atomic integers for the compilers in use. All operations act
+ * as full memory barriers.
+ */
+class Atomic
+{
+	public:
+		/**
+		 * @brief Reads a value shared between threads.
+		 *
+		 * @param value - The value to read.
+		 *
+		 * @return The value.
+		 */
+		static long load(volatile long *value)
+		{
+#ifdef _MSC_VER
+			return _InterlockedCompareExchange(value, 0, 0);
+#else
+			return __sync_val_compare_and_swap(value, 0, 0);
+#endif
+		}
+
+		/**
+		 * @brief Writes a value shared between threads.
+		 *
+		 * @param value - The value to write to.
+		 * @param newValue - The value to write.
+		 */
+		static void store(volatile long *value, long newValue)
+		{
+#ifdef _MSC_VER
+			_InterlockedExchange(value, newValue);
+#else
+			__sync_lock_test_and_set(value, newValue);
+			__sync_synchronize();
+#endif
+		}
+
+		/**
+		 * @brief Replaces a value.
+		 *
+		 * @param value - The value to replace.
+		 * @param newValue - The value to write.
+		 *
+		 * @return The value before replacing it.
+		 */
+		static long exchange(volatile long *value, long newValue)
+		{
+#ifdef _MSC_VER
+			return _InterlockedExchange(value, newValue);
+#else
+			long oldValue = __sync_lock_test_and_set(value, newValue);
+			__sync_synchronize();
+			return oldValue;
+#endif
+		}
+
+		/**
+		 * @brief Increments a value.
+		 *
+		 * @param value - The value to increment.
+		 *
+		 * @return The incremented value.
+		 */
+		static long increment(volatile long *value)
+		{
+#ifdef _MSC_VER
+			return _InterlockedIncrement(value);
+#else
+			return __sync_add_and_fetch(value, 1);
+#endif
+		}
+
+		/**
+		 * @brief Decrements a value.
+		 *
+		 * @param value - The value to decrement.
+		 *
+		 * @return The decremented value.
+		 */
+		static long decrement(volatile long *value)
+		{
+#ifdef _MSC_VER
+			return _InterlockedDecrement(value);
+#else
+			return __sync_sub_and_fetch(value, 1);
+#endif
+		}
+
+		/**
+		 * @brief Replaces a value if it has not changed.
+		 *
+		 * @param value - The value to replace.
+		 * @param expectedValue - The value expected to be replaced.
+		 * @param newValue - The value to write.
+		 *
+		 * @return True if the value was replaced.
+		 */
+		static bool compareAndSwap(volatile long *value, long expectedValue,
+			long newValue)
+		{
+#ifdef _MSC_VER
+			return _InterlockedCompareExchange(value, newValue, expectedValue)
+				== expectedValue;
+#else
+			return __sync_bool_compare_and_swap(value, expectedValue, newValue);
+#endif
+		}
+};
+
+#endif
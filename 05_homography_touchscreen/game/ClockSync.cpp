@@ -0,0 +1,55 @@
+#include "ClockSync.h"
+
+#include <boost/bind.hpp>
+
+#include "MessageTypes.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// ClockSync
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ClockSync::ClockSync(GameNetworkInterface *gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
+{
+	m_data.clientTime = 0;
+	m_data.serverTime = 0;
+
+	setMessageID(MESSAGE_ID_EVENT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ClockSync::setClientTime(boost::int64_t clientTime)
+{
+	m_data.clientTime = clientTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::int64_t ClockSync::clientTime()
+{
+	return m_data.clientTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ClockSync::setServerTime(boost::int64_t serverTime)
+{
+	m_data.serverTime = serverTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::int64_t ClockSync::serverTime()
+{
+	return m_data.serverTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ClockSync::isRequest()
+{
+	return m_data.serverTime == 0;
+}
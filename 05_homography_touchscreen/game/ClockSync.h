@@ -0,0 +1,37 @@
+#ifndef __GAME_CLOCK_SYNC_H
+#define __GAME_CLOCK_SYNC_H
+
+#include <boost/cstdint.hpp>
+
+#include "MessageSchema.h"
+#include "MessageTypes.h"
+#include "ForwardDeclarations.h"
+
+// Data to synchronize via network
+struct ClockSyncData
+{
+	boost::int64_t clientTime;
+	boost::int64_t serverTime;
+};
+
+// Measures the offset between the clocks of a client and the server. The
+// client sends its time, the server sends it back together with its own time.
+class ClockSync : public MessageSchema<MESSAGE_CLOCK_SYNC, ClockSyncData,
+	UPDATE_FREQUENCY_ONCE>
+{
+	public:
+		ClockSync(GameNetworkInterface *gameNetworkInterface);
+
+		// When the client sent the request, in microseconds of its clock
+		void setClientTime(boost::int64_t clientTime);
+		boost::int64_t clientTime();
+
+		// When the server answered, in microseconds of its clock, 0 for
+		// requests
+		void setServerTime(boost::int64_t serverTime);
+		boost::int64_t serverTime();
+
+		bool isRequest();
+};
+
+#endif
@@ -19,10 +19,21 @@ class GameObstacle;
 typedef boost::shared_ptr<GameObstacle> GameObstaclePtr;
 typedef std::vector<GameObstaclePtr> GameObstacles;
 
+class GameState;
+typedef boost::shared_ptr<const GameState> GameStatePtr;
+
+struct GameUnitState;
+typedef std::vector<GameUnitState> GameUnitStates;
+
+struct GameObstacleState;
+typedef std::vector<GameObstacleState> GameObstacleStates;
+
 class GameNetworkServer;
 class GameNetworkClient;
 class GameNetworkInterface;
 
 class NetworkServerSession;
 
+class ThreadPool;
+
 #endif
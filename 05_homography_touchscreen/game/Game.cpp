@@ -2,12 +2,20 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+
 #include "GameNetworkInterface.h"
 #include "GameUnit.h"
 #include "GameObstacle.h"
+#include "GameState.h"
 #include "MoveRequest.h"
 #include "HighlightRequest.h"
+#include "SelectionRequest.h"
 #include "NewPlayerID.h"
+#include "ThreadPool.h"
+#include "Atomic.h"
+#include "LatencyTracer.h"
+#include "Profiler.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -16,12 +24,36 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+// Work package size when distributing units over threads
+const int Game::s_unitsPerTask = 64;
+
+////////////////////////////////////////////////////////////////////////////////
+
 Game::Game(GameNetworkInterface *gameNetworkInterface)
 {
 	m_gameNetworkInterface = gameNetworkInterface;
+	m_threadPool = NULL;
+
+	// Cells are as large as the collision distance of two units
+	m_cellsPerRow = 480 / (int)(2 * GameUnit::s_radius) + 1;
 
 	m_ownPlayerID = ID_NONE;
 
+	m_interpolationDelay = boost::chrono::milliseconds(0);
+
+	m_isPredictingOwnUnits = false;
+	m_inputSequence = 0;
+
+	m_serverClock = NULL;
+
+	m_isKeepingHistory = false;
+
+	m_tick = 0;
+	m_tickTime = ServerClock::now();
+
+	m_receivedTick = 0;
+	m_receivedUnits = 0;
+
 	m_hasStarted = false;
 	m_hasFinished = false;
 	m_lastUnitTime = -1.0f;
@@ -176,7 +208,7 @@ void Game::load(int levelNumber)
 		newGameUnit->setOwner(ID_FIRST_CLIENT);
 		newGameUnit->setPosition((*unitPosition).x, (*unitPosition).y);
 		newGameUnit->setHunting(false);
-		m_gameUnits.push_back(newGameUnit);
+		addUnit(newGameUnit);
 	}
 
 	unitNumber = 1;
@@ -190,7 +222,7 @@ void Game::load(int levelNumber)
 		newGameUnit->setOwner(ID_FIRST_CLIENT + 1);
 		newGameUnit->setPosition((*unitPosition).x, (*unitPosition).y);
 		newGameUnit->setHunting(true);
-		m_gameUnits.push_back(newGameUnit);
+		addUnit(newGameUnit);
 	}
 
 	for (unsigned int i = 0; i < obstaclePositions.size(); i++)
@@ -200,7 +232,7 @@ void Game::load(int levelNumber)
 		newGameObstacle->setPosition(obstaclePositions[i].x,
 									 obstaclePositions[i].y);
 		newGameObstacle->setRadius(obstacleRadii[i]);
-		m_gameObstacles.push_back(newGameObstacle);
+		addObstacle(newGameObstacle);
 	}
 
 	std::stringstream info;
@@ -208,6 +240,8 @@ void Game::load(int levelNumber)
 	Logging::info(info.str());
 
 	m_timer.restart();
+
+	publishState();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -223,23 +257,198 @@ void Game::reset()
 		m_gameObstacles[i] = GameObstaclePtr();
 
 	m_gameObstacles.clear();
+
+	m_unitSlotsByID.clear();
+	m_obstacleSlotsByID.clear();
+	m_unitSlotsByOwner.clear();
+
+	m_stateBuffer.clear();
+	m_history.clear();
+	m_unitPredictor.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::addUnit(const GameUnitPtr &gameUnit)
+{
+	int slot = m_gameUnits.size();
+	m_gameUnits.push_back(gameUnit);
+
+	addToIndex(m_unitSlotsByID, gameUnit->messageID(), slot);
+
+	// The owner of a unit never changes after it has been created
+	PlayerID owner = gameUnit->owner();
+
+	if (owner >= m_unitSlotsByOwner.size())
+		m_unitSlotsByOwner.resize(owner + 1);
+
+	m_unitSlotsByOwner[owner].push_back(slot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::addObstacle(const GameObstaclePtr &gameObstacle)
+{
+	int slot = m_gameObstacles.size();
+	m_gameObstacles.push_back(gameObstacle);
+
+	addToIndex(m_obstacleSlotsByID, gameObstacle->messageID(), slot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::addToIndex(std::vector<int> &index, int key, int slot)
+{
+	// Message IDs are assigned consecutively, so the index stays dense
+	if (key >= (int)index.size())
+		index.resize(key + 1, -1);
+
+	index[key] = slot;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Game::render(cv::Mat &image)
 {
-	cv::rectangle(image, cv::Point(0, 0), cv::Point(480, 480),
-				  cv::Scalar(32, 32, 32), CV_FILLED);
+	// Render a consistent snapshot instead of the units being modified
+	GameStatePtr gameState = displayedState();
+
+	if (gameState)
+		render(image, *gameState);
+	else
+		render(image, GameState());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::render(cv::Mat &image, const GameState &gameState)
+{
+	// Only redraw what has changed since the last frame
+	m_renderCache.render(image, gameState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStatePtr Game::state() const
+{
+	return boost::atomic_load(&m_state);
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-	cv::rectangle(image, cv::Point(0, 472), cv::Point(480, 480),
-				  cv::Scalar(32, 128, 64), CV_FILLED);
+void Game::publishState()
+{
+	GameState *newState = new GameState;
+	newState->setOwnPlayerID(m_ownPlayerID);
 
 	for (unsigned int i = 0; i < m_gameObstacles.size(); i++)
-		m_gameObstacles[i]->render(image);
+		newState->addObstacle(m_gameObstacles[i]->state());
 
 	for (unsigned int i = 0; i < m_gameUnits.size(); i++)
-		m_gameUnits[i]->render(image);
+		newState->addUnit(m_gameUnits[i]->state());
+
+	GameStatePtr gameState(newState);
+
+	// Readers holding the previous state keep it alive until they are done
+	boost::atomic_store(&m_state, gameState);
+
+	if (m_isKeepingHistory)
+		m_history.add(gameState, GameStateBuffer::Clock::time_point(
+			boost::chrono::duration_cast<GameStateBuffer::Clock::duration>(
+				boost::chrono::microseconds(m_tickTime))));
+
+	if (m_interpolationDelay.count() <= 0)
+		return;
+
+	boost::chrono::steady_clock::time_point time
+		= boost::chrono::steady_clock::now();
+
+	// Date the state by the server step it belongs to, which is not affected
+	// by network jitter
+	if (m_serverClock && m_serverClock->isSynchronized())
+	{
+		boost::int64_t serverTime = 0;
+
+		for (unsigned int i = 0; i < m_gameUnits.size(); i++)
+			serverTime = std::max(serverTime, m_gameUnits[i]->serverTime());
+
+		if (serverTime != 0)
+			time = m_serverClock->localTime(serverTime);
+	}
+
+	m_stateBuffer.add(gameState, time);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::setInterpolationDelay(boost::chrono::milliseconds delay)
+{
+	m_interpolationDelay = delay;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::setServerClock(const ServerClock *serverClock)
+{
+	m_serverClock = serverClock;
+	m_unitPredictor.setServerClock(serverClock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::setKeepingHistory(bool isKeepingHistory)
+{
+	m_isKeepingHistory = isKeepingHistory;
+
+	if (!isKeepingHistory)
+		m_history.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStatePtr Game::stateAt(boost::int64_t serverTime) const
+{
+	GameStatePtr gameState;
+
+	// On the server, step times are timestamps of its own clock
+	if (m_isKeepingHistory)
+		gameState = m_history.interpolate(GameStateBuffer::Clock::time_point(
+			boost::chrono::duration_cast<GameStateBuffer::Clock::duration>(
+				boost::chrono::microseconds(serverTime))));
+
+	if (!gameState)
+		gameState = state();
+
+	return gameState;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::setPredictingOwnUnits(bool isPredictingOwnUnits)
+{
+	m_isPredictingOwnUnits = isPredictingOwnUnits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStatePtr Game::displayedState() const
+{
+	boost::chrono::steady_clock::time_point now
+		= boost::chrono::steady_clock::now();
+
+	GameStatePtr gameState;
+
+	if (m_interpolationDelay.count() > 0)
+		gameState = m_stateBuffer.interpolate(now - m_interpolationDelay);
+
+	if (!gameState)
+		gameState = state();
+
+	// The own units are shown at the present time, ahead of the others
+	if (m_isPredictingOwnUnits)
+		gameState = m_unitPredictor.apply(gameState, now);
+
+	return gameState;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -249,6 +458,22 @@ void Game::proceed()
 	float timeDifference = m_timer.elapsed();
 	m_timer.restart();
 
+	m_tick++;
+	m_tickTime = ServerClock::now();
+
+	runPostedFunctions();
+
+	step(timeDifference);
+
+	// Only this thread modifies the units, so stamp them here with the step
+	// they are sent with until the next one
+	stampStates();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::step(float timeDifference)
+{
 	if (!hasStarted())
 		return;
 
@@ -287,44 +512,154 @@ void Game::proceed()
 	if (hasFinished())
 		return;
 
-	for (unsigned int i = 0; i < m_gameUnits.size(); i++)
-	{
-		m_gameUnits[i]->move(timeDifference);
-		m_gameUnits[i]->reflectOnWalls();
+	// Moving, reflecting and separating from obstacles only modifies the unit
+	// itself, so all units can be processed in parallel
+	m_hasUnitArrived.assign(m_gameUnits.size(), false);
 
-		if (!m_gameUnits[i]->hasArrived() && !m_gameUnits[i]->isHunting()
-			&& m_gameUnits[i]->y() >= 480 - GameUnit::s_radius)
-		{
-			m_gameUnits[i]->setArrived(true);
+	forEachUnit(boost::bind(&Game::moveUnits, this, timeDifference, _1, _2));
 
+	for (unsigned int i = 0; i < m_hasUnitArrived.size(); i++)
+		if (m_hasUnitArrived[i])
+		{
 			m_lastUnitTime = m_durationTimer.elapsed();
+			break;
 		}
+
+	// Hunters never die, so each sheep only has to look for hunters nearby.
+	// Only the sheep itself is modified, which keeps the result independent
+	// of the order in which the threads process the units.
+	sortHuntersIntoCells();
+
+	forEachUnit(boost::bind(&Game::catchSheep, this, _1, _2));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::post(const boost::function<void ()> &function)
+{
+	boost::lock_guard<boost::mutex> lock(m_postedFunctionsMutex);
+
+	m_postedFunctions.push_back(function);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::runPostedFunctions()
+{
+	std::vector<boost::function<void ()> > functions;
+
+	// Run outside the lock, so that the network thread can post meanwhile
+	{
+		boost::lock_guard<boost::mutex> lock(m_postedFunctionsMutex);
+
+		functions.swap(m_postedFunctions);
 	}
 
-	for (unsigned int i = 0; i < m_gameUnits.size(); i++)
-		for (unsigned int j = 0; j < m_gameObstacles.size(); j++)
+	for (unsigned int i = 0; i < functions.size(); i++)
+		functions[i]();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::setThreadPool(ThreadPool *threadPool)
+{
+	m_threadPool = threadPool;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::forEachUnit(const boost::function<void (int, int)> &task)
+{
+	if (m_threadPool)
+		m_threadPool->parallelFor(0, m_gameUnits.size(), s_unitsPerTask, task);
+	else
+		task(0, m_gameUnits.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::moveUnits(float timeDifference, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		GameUnit &gameUnit = *m_gameUnits[i];
+
+		gameUnit.simulate(timeDifference, m_gameObstacles);
+
+		if (!gameUnit.hasArrived() && !gameUnit.isHunting()
+			&& gameUnit.y() >= 480 - GameUnit::s_radius)
 		{
-			if (!m_gameUnits[i]->collidesWith(*m_gameObstacles[j]))
-				continue;
+			gameUnit.setArrived(true);
 
-			m_gameUnits[i]->separateFrom(*m_gameObstacles[j]);
+			m_hasUnitArrived[i] = true;
 		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::sortHuntersIntoCells()
+{
+	m_hunterCells.resize(m_cellsPerRow * m_cellsPerRow);
+
+	for (unsigned int i = 0; i < m_hunterCells.size(); i++)
+		m_hunterCells[i].clear();
 
 	for (unsigned int i = 0; i < m_gameUnits.size(); i++)
-		for (unsigned int j = 0; j < m_gameUnits.size(); j++)
-		{
-			if (i == j)
-				continue;
+		if (m_gameUnits[i]->isHunting())
+			m_hunterCells[cellIndex(m_gameUnits[i]->position())].push_back(i);
+}
 
-			if (!m_gameUnits[i]->collidesWith(*m_gameUnits[j]))
-				continue;
+////////////////////////////////////////////////////////////////////////////////
 
-			if (!m_gameUnits[i]->isHunting())
-				m_gameUnits[i]->setLiving(false);
+int Game::cellIndex(const cv::Point &position) const
+{
+	int cellSize = 2 * GameUnit::s_radius;
 
-			if (!m_gameUnits[j]->isHunting())
-				m_gameUnits[j]->setLiving(false);
-		}
+	// Units pushed out of the arena are sorted into the border cells
+	int column = std::min(m_cellsPerRow - 1, std::max(0, position.x / cellSize));
+	int row = std::min(m_cellsPerRow - 1, std::max(0, position.y / cellSize));
+
+	return row * m_cellsPerRow + column;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::catchSheep(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		GameUnit &sheep = *m_gameUnits[i];
+
+		if (sheep.isHunting())
+			continue;
+
+		int cell = cellIndex(sheep.position());
+		int row = cell / m_cellsPerRow;
+		int column = cell % m_cellsPerRow;
+
+		bool isCaught = false;
+
+		// Colliding units are at most one cell apart
+		for (int y = std::max(0, row - 1);
+			 y <= std::min(m_cellsPerRow - 1, row + 1) && !isCaught; y++)
+			for (int x = std::max(0, column - 1);
+				 x <= std::min(m_cellsPerRow - 1, column + 1) && !isCaught; x++)
+			{
+				const std::vector<int> &hunters
+					= m_hunterCells[y * m_cellsPerRow + x];
+
+				for (unsigned int j = 0; j < hunters.size(); j++)
+					if (sheep.collidesWith(*m_gameUnits[hunters[j]]))
+					{
+						isCaught = true;
+						break;
+					}
+			}
+
+		if (isCaught)
+			sheep.setLiving(false);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -351,6 +686,17 @@ void Game::synchronize(PlayerID playerID)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Game::stampStates()
+{
+	for (unsigned int i = 0; i < m_gameUnits.size(); i++)
+		m_gameUnits[i]->setServerTime(m_tick, m_tickTime);
+
+	for (unsigned int i = 0; i < m_gameObstacles.size(); i++)
+		m_gameObstacles[i]->setServerTime(m_tick, m_tickTime);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Game::start()
 {
 	m_hasStarted = true;
@@ -379,15 +725,26 @@ void Game::handleNewPlayerID(MessageData messageData)
 	NewPlayerID newPlayerID(NULL);
 	newPlayerID.createFromData(messageData);
 
-	std::cout << "[Info] New player ID received." << std::endl;
+	Logging::info("New player ID received.");
 
 	m_ownPlayerID = newPlayerID.playerID();
+
+	publishState();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Game::handleGameUnit(MessageData messageData)
 {
+	PROFILE_SCOPE("game.handleGameUnit");
+
+	// This handler has been registered before the ones of the units, so it
+	// sees each update before the unit adopts it
+	GameUnit receivedGameUnit(NULL);
+	receivedGameUnit.createFromData(messageData);
+
+	beginReceivedStep(receivedGameUnit.serverTick());
+
 	GameUnitPtr matchingGameUnit = unitByID(messageData.messageID());
 
 	if (matchingGameUnit)
@@ -395,13 +752,57 @@ void Game::handleGameUnit(MessageData messageData)
 
 	GameUnitPtr newGameUnit(new GameUnit(m_gameNetworkInterface));
 	newGameUnit->createFromData(messageData);
-	m_gameUnits.push_back(newGameUnit);
+	addUnit(newGameUnit);
+
+	// Follow the traces echoed by the server
+	newGameUnit->onUpdate.connect(
+		boost::bind(&GameUnit::traceUpdate, newGameUnit.get()));
+
+	// Correct the prediction of the unit by the server's state
+	if (m_isPredictingOwnUnits)
+		newGameUnit->onUpdate.connect(
+			boost::bind(&Game::reconcileUnit, this, newGameUnit.get()));
+
+	newGameUnit->onUpdate.connect(
+		boost::bind(&Game::countReceivedUnit, this));
+
+	countReceivedUnit();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::beginReceivedStep(uint32_t tick)
+{
+	if (tick == m_receivedTick)
+		return;
+
+	// Units of the last step may have been replaced by newer states on the
+	// way, so publish the units that have arrived
+	if (m_receivedUnits > 0 && m_receivedUnits < m_gameUnits.size())
+		publishState();
+
+	m_receivedTick = tick;
+	m_receivedUnits = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::countReceivedUnit()
+{
+	m_receivedUnits++;
+
+	// Publish as soon as all units of the step have arrived, instead of
+	// mixing the units of two steps
+	if (m_receivedUnits == m_gameUnits.size())
+		publishState();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Game::handleGameObstacle(MessageData messageData)
 {
+	PROFILE_SCOPE("game.handleGameObstacle");
+
 	GameObstaclePtr matchingGameObstacle = obstacleByID(messageData.messageID());
 
 	if (matchingGameObstacle)
@@ -409,21 +810,26 @@ void Game::handleGameObstacle(MessageData messageData)
 
 	GameObstaclePtr newGameObstacle(new GameObstacle(m_gameNetworkInterface));
 	newGameObstacle->createFromData(messageData);
-	m_gameObstacles.push_back(newGameObstacle);
+	addObstacle(newGameObstacle);
+
+	publishState();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::reconcileUnit(GameUnit *gameUnit)
+{
+	m_unitPredictor.reconcile(*gameUnit, boost::chrono::steady_clock::now());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 const GameUnitPtr Game::unitByID(MessageID messageID) const
 {
-	for (GameUnits::const_iterator i = m_gameUnits.begin();
-		 i != m_gameUnits.end(); i++)
-	{
-		if ((*i)->messageID() == messageID)
-			return (*i);
-	}
+	if (messageID >= m_unitSlotsByID.size() || m_unitSlotsByID[messageID] < 0)
+		return GameUnitPtr();
 
-	return GameUnitPtr();
+	return m_gameUnits[m_unitSlotsByID[messageID]];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -434,21 +840,11 @@ const GameUnitPtr Game::unitByIndex(PlayerID playerID, uint8_t index) const
 	if (m_ownPlayerID != ID_NONE && m_ownPlayerID != playerID)
 		return GameUnitPtr();
 
-	uint8_t currentIndex = 0;
-
-	for (GameUnits::const_iterator i = m_gameUnits.begin();
-		 i != m_gameUnits.end(); i++)
-	{
-		if ((*i)->owner() != playerID)
-			continue;
-
-		if (currentIndex == index)
-			return *i;
-
-		currentIndex++;
-	}
+	if (playerID >= m_unitSlotsByOwner.size()
+		|| index >= m_unitSlotsByOwner[playerID].size())
+		return GameUnitPtr();
 
-	return GameUnitPtr();
+	return m_gameUnits[m_unitSlotsByOwner[playerID][index]];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -462,25 +858,65 @@ const GameUnitPtr Game::unitByIndex(uint8_t index) const
 
 const GameObstaclePtr Game::obstacleByID(MessageID messageID) const
 {
-	for (GameObstacles::const_iterator i = m_gameObstacles.begin();
-		 i != m_gameObstacles.end(); i++)
-	{
-		if ((*i)->messageID() == messageID)
-			return (*i);
-	}
+	if (messageID >= m_obstacleSlotsByID.size()
+		|| m_obstacleSlotsByID[messageID] < 0)
+		return GameObstaclePtr();
 
-	return GameObstaclePtr();
+	return m_gameObstacles[m_obstacleSlotsByID[messageID]];
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Game::moveUnit(int index, float angle, float strength)
+void Game::moveUnit(int index, float angle, float strength, uint32_t traceID)
 {
 	MoveRequest moveRequest(m_gameNetworkInterface);
 	moveRequest.setUnitIndex(index);
 	moveRequest.setAngle(angle);
 	moveRequest.setStrength(strength);
+	moveRequest.setTraceID(traceID);
+	uint32_t inputSequence = Atomic::increment(&m_inputSequence);
+	moveRequest.setInputSequence(inputSequence);
+
+	// Called by the detection thread, so read the unit from the published
+	// state instead of the one the network thread updates
+	GameStatePtr gameState = state();
+	const GameUnitState *gameUnit = NULL;
+
+	if (gameState)
+		gameUnit = gameState->unitByIndex(index);
+
+	if (m_isPredictingOwnUnits && gameUnit)
+		m_unitPredictor.addInput(*gameUnit, inputSequence,
+			GameUnit::requestedAcceleration(angle, strength),
+			boost::chrono::steady_clock::now());
+
 	moveRequest.synchronize(ID_SERVER);
+
+	LatencyTracer::instance()->markSent(traceID);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Game::selectUnit(cv::Point2f point)
+{
+	SelectionRequest selectionRequest(m_gameNetworkInterface);
+	selectionRequest.setPoint(point);
+
+	// The own units are displayed at the present time if they are predicted,
+	// and as far in the past as the other units otherwise. Without knowing
+	// the server's clock, the server tests against its current state.
+	if (m_serverClock && m_serverClock->isSynchronized())
+	{
+		boost::int64_t viewTime = m_serverClock->serverTime();
+
+		if (!m_isPredictingOwnUnits)
+			viewTime -= boost::chrono::duration_cast<
+				boost::chrono::microseconds>(m_interpolationDelay).count();
+
+		selectionRequest.setViewTime(viewTime);
+	}
+
+	selectionRequest.synchronize(ID_SERVER);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -2,10 +2,19 @@
 #define __GAME_GAME_H
 
 #include <boost/timer.hpp>
+#include <boost/function.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "MessageData.h"
+#include "RenderCache.h"
+#include "GameStateBuffer.h"
+#include "UnitPredictor.h"
+#include "ServerClock.h"
 #include "ForwardDeclarations.h"
 
 class Game
@@ -16,9 +25,54 @@ class Game
 		void load(int levelNumber);
 
 		void render(cv::Mat &image);
+		void render(cv::Mat &image, const GameState &gameState);
+
+		// Returns the most recently published game state. The state is
+		// immutable and can safely be read from any thread.
+		GameStatePtr state() const;
+
+		// Builds a new game state from the current units and obstacles and
+		// publishes it atomically. Must be called by the thread modifying the
+		// game.
+		void publishState();
+
+		// Displays units this far in the past, interpolated between the
+		// published states, so that they move smoothly between server steps.
+		// With 0, the most recent state is displayed.
+		void setInterpolationDelay(boost::chrono::milliseconds delay);
+
+		// Moves the own units locally as soon as they are requested to move,
+		// instead of waiting for the server to confirm
+		void setPredictingOwnUnits(bool isPredictingOwnUnits);
+
+		// Returns the state to display now, which is the most recent state
+		// or an interpolated one, with the own units predicted if enabled
+		GameStatePtr displayedState() const;
+
+		// Dates received states by the server's clock instead of their time
+		// of arrival. The clock has to outlive the game.
+		void setServerClock(const ServerClock *serverClock);
+
+		// Keeps the states of the last steps, so that requests can be
+		// resolved against what clients saw when they sent them
+		void setKeepingHistory(bool isKeepingHistory);
+
+		// Returns the state at a time of the server's clock, interpolated
+		// between the kept steps and limited to the oldest one. Without a
+		// history, the most recent state is returned.
+		GameStatePtr stateAt(boost::int64_t serverTime) const;
 
 		void proceed();
 
+		// Runs the function on the thread proceeding the game at the start of
+		// the next step. Requests received by other threads go through here,
+		// so that they never modify units while a step is computed.
+		void post(const boost::function<void ()> &function);
+
+		// Lets proceed distribute its work over the threads of the pool. If no
+		// pool is set, the game proceeds in the calling thread only.
+		void setThreadPool(ThreadPool *threadPool);
+
 		void synchronize(NetworkServerSession *session);
 		void synchronize(PlayerID playerID);
 
@@ -33,9 +87,15 @@ class Game
 
 		const GameObstaclePtr obstacleByID(MessageID messageID) const;
 
-		void moveUnit(int index, float angle, float strength);
+		// The trace ID identifies the input for latency measurements
+		void moveUnit(int index, float angle, float strength,
+			uint32_t traceID = 0);
 		void highlightUnit(int index, bool isHighlighted = true);
 
+		// Lets the server toggle the own unit at the touch point, as displayed
+		// at the time of the call
+		void selectUnit(cv::Point2f point);
+
 	protected:
 		void initializeMessageHandlers();
 
@@ -44,8 +104,38 @@ class Game
 		void handleGameUnit(MessageData messageData);
 		void handleGameObstacle(MessageData messageData);
 
+		void reconcileUnit(GameUnit *gameUnit);
+
+		// Publish the received units once per server step. The previous step
+		// is over as soon as a unit of another step arrives.
+		void beginReceivedStep(uint32_t tick);
+		void countReceivedUnit();
+
+		void runPostedFunctions();
+
+		// Moves the units and lets hunters catch sheep
+		void step(float timeDifference);
+
+		// Stamps units and obstacles with the last step before sending them
+		void stampStates();
+
 		void reset();
 
+		void addUnit(const GameUnitPtr &gameUnit);
+		void addObstacle(const GameObstaclePtr &gameObstacle);
+
+		static void addToIndex(std::vector<int> &index, int key, int slot);
+
+		void forEachUnit(const boost::function<void (int, int)> &task);
+
+		void moveUnits(float timeDifference, int begin, int end);
+
+		void sortHuntersIntoCells();
+		int cellIndex(const cv::Point &position) const;
+		void catchSheep(int begin, int end);
+
+		static const int s_unitsPerTask;
+
 		bool m_hasStarted;
 		bool m_hasFinished;
 
@@ -54,9 +144,60 @@ class Game
 
 		double m_lastUnitTime;
 
+		// The number and the server time of the last step, sent with the
+		// state of each unit and obstacle
+		uint32_t m_tick;
+		boost::int64_t m_tickTime;
+
+		// The server step of the units received last and how many of them
+		// have arrived so far
+		uint32_t m_receivedTick;
+		unsigned int m_receivedUnits;
+
+		// Functions posted since the last step
+		std::vector<boost::function<void ()> > m_postedFunctions;
+		boost::mutex m_postedFunctionsMutex;
+
 		GameUnits m_gameUnits;
 		GameObstacles m_gameObstacles;
 
+		// Positions in m_gameUnits and m_gameObstacles by message ID, -1 if
+		// there is no such unit or obstacle
+		std::vector<int> m_unitSlotsByID;
+		std::vector<int> m_obstacleSlotsByID;
+
+		// Positions in m_gameUnits of each player's units, by player ID
+		std::vector<std::vector<int> > m_unitSlotsByOwner;
+
+		GameStatePtr m_state;
+
+		// Recently published states and how far back they are displayed
+		GameStateBuffer m_stateBuffer;
+		boost::chrono::milliseconds m_interpolationDelay;
+
+		// The states of the last steps on the server, dated by step time
+		GameStateBuffer m_history;
+		bool m_isKeepingHistory;
+
+		// Local predictions of the own units and the number of the last move
+		// request sent, which may come from several threads
+		UnitPredictor m_unitPredictor;
+		bool m_isPredictingOwnUnits;
+		volatile long m_inputSequence;
+
+		const ServerClock *m_serverClock;
+
+		RenderCache m_renderCache;
+
+		ThreadPool *m_threadPool;
+
+		// Whether a unit arrived during the current step
+		std::vector<char> m_hasUnitArrived;
+
+		// Indices of the hunting units per cell of a uniform grid
+		std::vector<std::vector<int> > m_hunterCells;
+		int m_cellsPerRow;
+
 		GameNetworkInterface *m_gameNetworkInterface;
 
 		PlayerID m_ownPlayerID;
@@ -6,6 +6,7 @@
 
 #include "Game.h"
 #include "GameNetworkClient.h"
+#include "ClockSync.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,7 +24,22 @@ GameClient::GameClient()
 	m_gameNetworkClient->onConnectionClosed.connect(
 		boost::bind(&GameClient::handleConnectionClosed, this));
 
+	m_gameNetworkClient->addMessageHandler(
+		MESSAGE_CLOCK_SYNC,
+		MESSAGE_ID_EVENT,
+		boost::bind(&GameClient::handleClockSync, this, _1));
+
 	m_game = GamePtr(new Game(m_gameNetworkClient));
+
+	// Date received states by the server's steps instead of their arrival
+	m_game->setServerClock(&m_serverClock);
+
+	// Display units a bit more than two server steps in the past, so that
+	// there are states to interpolate between despite network jitter
+	m_game->setInterpolationDelay(boost::chrono::milliseconds(50));
+
+	// Let the own units react to input without waiting for the server
+	m_game->setPredictingOwnUnits(true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -32,6 +48,9 @@ void GameClient::run()
 {
 	// Run the network client after having registered all necessary messages
 	m_gameNetworkClient->run();
+
+	m_clockSyncThread = boost::thread(
+		boost::bind(&GameClient::synchronizeClock, this));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +64,9 @@ void GameClient::connectToServer(std::string serverAddress)
 
 void GameClient::stop()
 {
+	m_clockSyncThread.interrupt();
+	m_clockSyncThread.join();
+
 	if (m_gameNetworkClient)
 	{
 		m_gameNetworkClient->onConnectionClosed.disconnect(
@@ -92,3 +114,56 @@ GamePtr GameClient::game()
 {
 	return m_game;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+const ServerClock &GameClient::serverClock() const
+{
+	return m_serverClock;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameClient::handleClockSync(MessageData messageData)
+{
+	ClockSync clockSync(m_gameNetworkClient);
+	clockSync.createFromData(messageData);
+
+	if (clockSync.isRequest())
+		return;
+
+	m_serverClock.addSample(clockSync.clientTime(), clockSync.serverTime(),
+		ServerClock::now());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameClient::synchronizeClock()
+{
+	// Enough quick exchanges to fill the clock's samples
+	const int initialRequests = 8;
+	int requestCount = 0;
+
+	try
+	{
+		while (true)
+		{
+			if (m_gameNetworkClient->isConnected())
+			{
+				ClockSync clockSync(m_gameNetworkClient);
+				clockSync.setClientTime(ServerClock::now());
+				clockSync.synchronize(ID_SERVER);
+
+				requestCount++;
+			}
+			else
+				requestCount = 0;
+
+			boost::this_thread::sleep(boost::posix_time::milliseconds(
+				requestCount < initialRequests ? 100 : 1000));
+		}
+	}
+	catch (boost::thread_interrupted &)
+	{
+	}
+}
@@ -4,10 +4,12 @@
 #include <boost/asio.hpp>
 #include <boost/signal.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "MessageData.h"
+#include "ServerClock.h"
 #include "ForwardDeclarations.h"
 
 /**
@@ -54,6 +56,13 @@ class GameClient
 
 		GamePtr game();
 
+		/**
+		 * @brief Returns the estimate of the server’s clock.
+		 *
+		 * @return The server clock, synchronized while connected.
+		 */
+		const ServerClock &serverClock() const;
+
 		/** @brief Signal emitted if stopping the application is requested. **/
 		boost::signal<void ()> onStopApplication;
 
@@ -64,8 +73,21 @@ class GameClient
 
 		void sendRequests();
 
+		void handleClockSync(MessageData messageData);
+
+		/**
+		 * @brief Measures the offset to the server’s clock periodically.
+		 *
+		 * Sends requests in quick succession until enough samples are
+		 * gathered, and then once a second to follow the clocks’ drift.
+		 */
+		void synchronizeClock();
+
 		GamePtr m_game;
 
+		ServerClock m_serverClock;
+		boost::thread m_clockSyncThread;
+
 		GameNetworkClient *m_gameNetworkClient;
 };
 
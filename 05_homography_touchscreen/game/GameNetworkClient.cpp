@@ -4,6 +4,8 @@
 #include <boost/signal.hpp>
 
 #include "NetworkClient.h"
+#include "GameNetworkServer.h"
+#include "LocalServerSession.h"
 #include "MessageTypes.h"
 #include "Logging.h"
 
@@ -13,6 +15,14 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+GameNetworkClient::GameNetworkClient()
+{
+	m_networkClient = NULL;
+	m_localSession = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void GameNetworkClient::run()
 {
 	// Create a new network server
@@ -45,6 +55,12 @@ void GameNetworkClient::stop()
 {
 	removeAllMessageHandlers();
 
+	if (m_localSession)
+	{
+		m_localSession->close();
+		m_localSession = NULL;
+	}
+
 	m_networkClient->stop();
 }
 
@@ -73,7 +89,12 @@ void GameNetworkClient::send(MessageData messageData, PlayerID receiverID)
 	}
 
 	// Only allow sending messages to the server
-	if (receiverID == ID_SERVER)
+	if (receiverID != ID_SERVER)
+		return;
+
+	if (m_localSession)
+		m_localSession->receive(messageData);
+	else
 		m_networkClient->send(messageData);
 }
 
@@ -81,6 +102,9 @@ void GameNetworkClient::send(MessageData messageData, PlayerID receiverID)
 
 bool GameNetworkClient::isConnected()
 {
+	if (m_localSession)
+		return true;
+
 	return m_networkClient->isConnected();
 }
 
@@ -95,6 +119,21 @@ bool GameNetworkClient::acceptsConnection()
 
 void GameNetworkClient::connectToServer(std::string serverAddress)
 {
+	GameNetworkServer *localServer = GameNetworkServer::localServer();
+
+	// Bypass the network stack for a server in the same process
+	if (localServer && !m_localSession
+		&& (serverAddress == "127.0.0.1" || serverAddress == "localhost"))
+	{
+		m_localSession = localServer->acceptLocalSession(this);
+
+		Logging::info("Connected to the server in this process.");
+
+		onConnectionEstablished();
+
+		return;
+	}
+
 	m_networkClient->connectToServer(serverAddress);
 }
 
@@ -102,6 +141,16 @@ void GameNetworkClient::connectToServer(std::string serverAddress)
 
 void GameNetworkClient::disconnectFromServer()
 {
+	if (m_localSession)
+	{
+		m_localSession->close();
+		m_localSession = NULL;
+
+		onConnectionClosed();
+
+		return;
+	}
+
 	m_networkClient->disconnectFromServer();
 }
 
@@ -111,3 +160,10 @@ void GameNetworkClient::reconnectToServer()
 {
 	m_networkClient->reconnectToServer();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameNetworkClient::handleLocalMessage(MessageData messageData)
+{
+	handleMessage(messageData, ID_SERVER);
+}
@@ -5,6 +5,7 @@
 
 // Forward declarations
 class NetworkClient;
+class LocalServerSession;
 
 /**
  * @class GameNetworkClient
@@ -16,6 +17,8 @@ class NetworkClient;
 class GameNetworkClient : public GameNetworkInterface
 {
 	public:
+		GameNetworkClient();
+
 		/**
 		 * @brief Runs the game network client.
 		 *
@@ -83,6 +86,16 @@ class GameNetworkClient : public GameNetworkInterface
 		 */
 		void reconnectToServer();
 
+		/**
+		 * @brief Handles a message of a server in the same process.
+		 *
+		 * Called by the local session in its own thread, just like the
+		 * low-level client calls back for messages received via TCP.
+		 *
+		 * @param messageData - The message’s data.
+		 */
+		void handleLocalMessage(MessageData messageData);
+
 		/** @brief Signal emitted whenever a connection has been established. */
 		boost::signal<void ()> onConnectionEstablished;
 
@@ -95,6 +108,9 @@ class GameNetworkClient : public GameNetworkInterface
 	protected:
 		/** @brief The low-level network client. */
 		NetworkClient *m_networkClient;
+
+		/** @brief The session with a server in the same process or NULL. */
+		LocalServerSession *m_localSession;
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "GameNetworkInterface.h"
 
+#include "Profiler.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -62,6 +63,8 @@ void GameNetworkInterface::removeAllMessageHandlers()
 void GameNetworkInterface::handleMessage(MessageData messageData,
 	PlayerID senderID)
 {
+	PROFILE_SCOPE("network.handleMessage");
+
 	bool handlerFound = false;
 
 	// Copy to prevent multiple thread access and deadlocks
@@ -3,8 +3,11 @@
 #include <boost/thread.hpp>
 #include <boost/signal.hpp>
 
+#include <algorithm>
+
 #include "NetworkServer.h"
 #include "NetworkServerSession.h"
+#include "LocalServerSession.h"
 #include "PlayerProfile.h"
 #include "Logging.h"
 
@@ -14,6 +17,11 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+GameNetworkServer *GameNetworkServer::s_localServer = NULL;
+boost::mutex GameNetworkServer::s_localServerMutex;
+
+////////////////////////////////////////////////////////////////////////////////
+
 GameNetworkServer::GameNetworkServer()
 {
 
@@ -40,17 +48,45 @@ void GameNetworkServer::run()
 		boost::bind(&GameNetworkServer::handleSessionAccepted, this, _1));
 
 	// Start the network server in a new thread
-	boost::thread serverThread(
-		boost::bind(&NetworkServer::run, m_networkServer));
+	m_networkServer->start();
+
+	// Let clients in this process connect without a socket
+	boost::lock_guard<boost::mutex> lock(s_localServerMutex);
+	s_localServer = this;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameNetworkServer::stop()
 {
+	{
+		boost::lock_guard<boost::mutex> lock(s_localServerMutex);
+
+		if (s_localServer == this)
+			s_localServer = NULL;
+	}
+
 	removeAllMessageHandlers();
 
+	// Sessions closing during shutdown must not reach the owner, which is
+	// stopping as well. Signals are not thread-safe, so disconnect in the
+	// network server’s thread, before it is torn down.
+	m_networkServer->ioService().post(
+		boost::bind(&GameNetworkServer::handleStop, this));
+
+	// Returns after the last handler, so this may be deleted afterwards
 	m_networkServer->stop();
+
+	delete m_networkServer;
+	m_networkServer = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameNetworkServer::handleStop()
+{
+	onSessionClosed.disconnect_all_slots();
+	onSessionAccepted.disconnect_all_slots();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -84,32 +120,61 @@ void GameNetworkServer::send(MessageData messageData, PlayerID receiverID)
 		return;
 	}
 
-	// If defined, send the message to all of the clients
+	// Keep sessions from being closed and reused while sending
+	boost::lock_guard<boost::mutex> lock(m_playerProfilesMutex);
+
+	// If defined, send the message to all of the clients, sharing one copy
+	// of the data between all sessions
 	if (receiverID == ID_ALL_CLIENTS)
+	{
+		MessageDataPtr sharedMessageData(new MessageData(messageData));
+
 		for (PlayerProfiles::iterator i = m_playerProfiles.begin();
 			 i != m_playerProfiles.end(); i++)
 		{
-			(*i)->session()->send(messageData);
+			(*i)->session()->send(sharedMessageData);
 		}
 
+		return;
+	}
+
 	// Else just send the message to the desired receiver
-	else
+	PlayerProfilesByID::const_iterator playerProfile
+		= m_playerProfilesByID.find(receiverID);
+
+	if (playerProfile == m_playerProfilesByID.end())
 	{
-		PlayerProfilePtr playerProfile = playerProfileByID(receiverID);
+		Logging::error("Cannot send message to non-existing player.");
+		return;
+	}
 
-		if (playerProfile)
-		{
-			Logging::error("Cannot send message to non-existing player.");
-			return;
-		}
+	NetworkServerSession *session = playerProfile->second->session();
+
+	if (session)
+		session->send(messageData);
+	else
+		Logging::warning("Trying to send message to unconnected player.");
+}
 
-		NetworkServerSession *session = playerProfile->session();
+////////////////////////////////////////////////////////////////////////////////
 
-		if (session)
-			session->send(messageData);
-		else
-			Logging::warning("Trying to send message to unconnected player.");
-	}
+GameNetworkServer *GameNetworkServer::localServer()
+{
+	boost::lock_guard<boost::mutex> lock(s_localServerMutex);
+	return s_localServer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LocalServerSession *GameNetworkServer::acceptLocalSession(
+	GameNetworkClient *client)
+{
+	LocalServerSession *session
+		= new LocalServerSession(m_networkServer->ioService(), client);
+
+	m_networkServer->addSession(session);
+
+	return session;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -121,31 +186,66 @@ void GameNetworkServer::handleSessionAccepted(NetworkServerSession *session)
 	PlayerProfilePtr newProfile(new PlayerProfile);
 	newProfile->setPlayerID(m_nextPlayerID++);
 	newProfile->setSession(session);
-	m_playerProfiles.push_back(newProfile);
+
+	{
+		boost::lock_guard<boost::mutex> lock(m_playerProfilesMutex);
+		m_playerProfiles.push_back(newProfile);
+		m_playerProfilesByID[newProfile->playerID()] = newProfile;
+		m_playerProfilesBySession[session] = newProfile;
+	}
 
 	// Start handling messages received from this player
 	session->onMessageReceived.connect(
 		boost::bind(&GameNetworkServer::handleMessageReceived,
 			this, session, _1));
 
-	// Notify if a session has been closed
+	// Tear down the session when it has been closed
 	session->onClosed.connect(
-		boost::bind(boost::ref(onSessionClosed), session));
+		boost::bind(&GameNetworkServer::handleSessionClosed, this, session));
 
 	onSessionAccepted(session);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void GameNetworkServer::handleSessionClosed(NetworkServerSession *session)
+{
+	Logging::info("Game server closed connection.");
+
+	onSessionClosed(session);
+
+	{
+		boost::lock_guard<boost::mutex> lock(m_playerProfilesMutex);
+
+		PlayerProfilesBySession::iterator playerProfile
+			= m_playerProfilesBySession.find(session);
+
+		if (playerProfile != m_playerProfilesBySession.end())
+		{
+			m_playerProfilesByID.erase(playerProfile->second->playerID());
+
+			m_playerProfiles.erase(std::find(m_playerProfiles.begin(),
+				m_playerProfiles.end(), playerProfile->second));
+
+			m_playerProfilesBySession.erase(playerProfile);
+		}
+	}
+
+	// No more messages are sent to the session, so it may be reused
+	m_networkServer->removeSession(session);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void GameNetworkServer::handleMessageReceived(NetworkServerSession *session,
 	MessageData messageData)
 {
 	if (messageData.contentType() == ID_NONE)
 	{
-		Logging::warning((std::string)"Incoming message has no type."
+		Logging::warning((std::string)"Incoming message has no type. "
 			+ "Closing connection to client.");
 
-		onSessionClosed(session);
+		session->disconnect();
 
 		return;
 	}
@@ -176,14 +276,15 @@ void GameNetworkServer::handleMessageReceived(NetworkServerSession *session,
 const PlayerProfilePtr GameNetworkServer::playerProfileByID(PlayerID playerID)
 	const
 {
-	for (PlayerProfiles::const_iterator i = m_playerProfiles.begin();
-		 i != m_playerProfiles.end(); i++)
-	{
-		if ((*i)->playerID() == playerID)
-			return (*i);
-	}
+	boost::lock_guard<boost::mutex> lock(m_playerProfilesMutex);
+
+	PlayerProfilesByID::const_iterator playerProfile
+		= m_playerProfilesByID.find(playerID);
+
+	if (playerProfile == m_playerProfilesByID.end())
+		return PlayerProfilePtr();
 
-	return PlayerProfilePtr();
+	return playerProfile->second;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -191,12 +292,13 @@ const PlayerProfilePtr GameNetworkServer::playerProfileByID(PlayerID playerID)
 const PlayerProfilePtr GameNetworkServer::playerProfileBySession(
 	NetworkServerSession *session) const
 {
-	for (PlayerProfiles::const_iterator i = m_playerProfiles.begin();
-		 i != m_playerProfiles.end(); i++)
-	{
-		if ((*i)->session() == session)
-			return (*i);
-	}
+	boost::lock_guard<boost::mutex> lock(m_playerProfilesMutex);
+
+	PlayerProfilesBySession::const_iterator playerProfile
+		= m_playerProfilesBySession.find(session);
+
+	if (playerProfile == m_playerProfilesBySession.end())
+		return PlayerProfilePtr();
 
-	return PlayerProfilePtr();
+	return playerProfile->second;
 }
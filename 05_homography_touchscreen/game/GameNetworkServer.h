@@ -3,6 +3,8 @@
 
 #include <boost/asio.hpp>
 #include <boost/signal.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <vector>
 
@@ -13,6 +15,7 @@
 class Message;
 class NetworkServer;
 class NetworkServerSession;
+class LocalServerSession;
 
 /**
  * @class GameNetworkServer
@@ -38,6 +41,7 @@ class GameNetworkServer : public GameNetworkInterface
 		 * @brief Stops the game network server.
 		 *
 		 * Stops the game network server by stopping the low-level server.
+		 * Returns once the network server’s thread has finished.
 		 */
 		void stop();
 
@@ -51,6 +55,27 @@ class GameNetworkServer : public GameNetworkInterface
 		 */
 		void send(MessageData messageData, PlayerID receiverID);
 
+		/**
+		 * @brief Returns the server running in this process.
+		 *
+		 * Clients in the same process connect to this server directly instead
+		 * of via TCP.
+		 *
+		 * @return The running server or NULL if there is none.
+		 */
+		static GameNetworkServer *localServer();
+
+		/**
+		 * @brief Accepts a client running in the same process.
+		 *
+		 * Adds a session passing messages in memory, which is accepted like a
+		 * TCP session in the network server’s thread.
+		 *
+		 * @param client - The client to connect.
+		 * @return The session the client sends its messages to.
+		 */
+		LocalServerSession *acceptLocalSession(GameNetworkClient *client);
+
 		const PlayerProfilePtr playerProfileByID(PlayerID playerID) const;
 		const PlayerProfilePtr playerProfileBySession(
 			NetworkServerSession *session) const;
@@ -61,6 +86,13 @@ class GameNetworkServer : public GameNetworkInterface
 		boost::signal<void (NetworkServerSession *)> onSessionAccepted;
 
 	protected:
+		/**
+		 * @brief Disconnects the owner from the sessions.
+		 *
+		 * Called in the network server’s thread when stopping.
+		 */
+		void handleStop();
+
 		/**
 		 * @brief Handles accepted sessions.
 		 *
@@ -70,6 +102,16 @@ class GameNetworkServer : public GameNetworkInterface
 		 */
 		void handleSessionAccepted(NetworkServerSession *session);
 
+		/**
+		 * @brief Handles closed sessions.
+		 *
+		 * Announces the closed session, forgets the player and lets the
+		 * network server reuse the session.
+		 *
+		 * @param session - The client’s network session.
+		 */
+		void handleSessionClosed(NetworkServerSession *session);
+
 		/**
 		 * @brief Handles incoming messages.
 		 *
@@ -84,9 +126,33 @@ class GameNetworkServer : public GameNetworkInterface
 		/** @brief The network server which provides low-level functions. */
 		NetworkServer *m_networkServer;
 
+		typedef boost::unordered_map<PlayerID, PlayerProfilePtr>
+			PlayerProfilesByID;
+		typedef boost::unordered_map<NetworkServerSession *, PlayerProfilePtr>
+			PlayerProfilesBySession;
+
 		PlayerID m_nextPlayerID;
 
+		/** @brief All connected players, in the order they connected. */
 		PlayerProfiles m_playerProfiles;
+
+		/** @brief The connected players indexed by their ID. */
+		PlayerProfilesByID m_playerProfilesByID;
+
+		/** @brief The connected players indexed by their session. */
+		PlayerProfilesBySession m_playerProfilesBySession;
+
+		/**
+		 * @brief Mutex guarding the player profiles.
+		 *
+		 * Sessions are added and removed in the network server’s thread while
+		 * the game sends messages to them from its own thread.
+		 */
+		mutable boost::mutex m_playerProfilesMutex;
+
+		/** @brief The server local clients connect to. */
+		static GameNetworkServer *s_localServer;
+		static boost::mutex s_localServerMutex;
 };
 
 #endif
@@ -7,6 +7,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "GameNetworkInterface.h"
+#include "GameState.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -16,30 +17,42 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 GameObstacle::GameObstacle(GameNetworkInterface *gameNetworkInterface)
-	: Message(gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
 {
-	// Set up obstacle data for network transmission via messages
-	registerMessageType(MESSAGE_GAME_OBSTACLE, &m_gameObstacleData,
-		sizeof(GameObstacleData), UPDATE_FREQUENCY_ALWAYS);
-
 	setRadius(64);
+	setServerTime(0, 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void GameObstacle::render(cv::Mat &image)
+void GameObstacle::render(cv::Mat &image,
+						  const GameObstacleState &gameObstacleState)
 {
 	cv::Scalar color(128, 128, 128);
 
-	cv::circle(image, cv::Point(x(), y()), radius(), color, CV_FILLED, CV_AA);
+	cv::circle(image, gameObstacleState.position(), gameObstacleState.radius,
+			   color, CV_FILLED, CV_AA);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameObstacleState GameObstacle::state() const
+{
+	GameObstacleState gameObstacleState;
+	gameObstacleState.messageID = messageID();
+	gameObstacleState.x = m_data.x;
+	gameObstacleState.y = m_data.y;
+	gameObstacleState.radius = m_data.radius;
+
+	return gameObstacleState;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameObstacle::setPosition(float x, float y)
 {
-	m_gameObstacleData.x = x;
-	m_gameObstacleData.y = y;
+	m_data.x = x;
+	m_data.y = y;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -53,26 +66,49 @@ cv::Point GameObstacle::position() const
 
 float GameObstacle::x() const
 {
-	return m_gameObstacleData.x;
+	return m_data.x;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float GameObstacle::y() const
 {
-	return m_gameObstacleData.y;
+	return m_data.y;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameObstacle::setRadius(float radius)
 {
-	m_gameObstacleData.radius = radius;
+	m_data.radius = radius;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float GameObstacle::radius() const
 {
-	return m_gameObstacleData.radius;
+	return m_data.radius;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameObstacle::setServerTime(uint32_t serverTick,
+	boost::int64_t serverTime)
+{
+	m_data.serverTick = serverTick;
+	m_data.serverTime = serverTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GameObstacle::serverTick() const
+{
+	return m_data.serverTick;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::int64_t GameObstacle::serverTime() const
+{
+	return m_data.serverTime;
 }
@@ -2,19 +2,37 @@
 #define __GAME_GAME_OBSTACLE_H
 
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
-#include "Message.h"
+#include "MessageSchema.h"
+#include "MessageTypes.h"
 #include "MessageData.h"
 #include "ForwardDeclarations.h"
 
-class GameObstacle : public Message
+// Data to synchronize via network
+struct GameObstacleData
+{
+	float x;
+	float y;
+
+	float radius;
+
+	uint32_t serverTick;
+	boost::int64_t serverTime;
+};
+
+class GameObstacle : public MessageSchema<MESSAGE_GAME_OBSTACLE,
+	GameObstacleData, UPDATE_FREQUENCY_ALWAYS>
 {
 	public:
 		GameObstacle(GameNetworkInterface *gameNetworkInterface);
 
-		void render(cv::Mat &image);
+		static void render(cv::Mat &image,
+						   const GameObstacleState &gameObstacleState);
+
+		GameObstacleState state() const;
 
 		void setPosition(float x, float y);
 		cv::Point position() const;
@@ -24,19 +42,13 @@ class GameObstacle : public Message
 		void setRadius(float radius);
 		float radius() const;
 
+		// The step of the server and the server time the state belongs to
+		void setServerTime(uint32_t serverTick, boost::int64_t serverTime);
+		uint32_t serverTick() const;
+		boost::int64_t serverTime() const;
+
 	protected:
 		void debug();
-
-		// Data to synchronize via network
-		struct GameObstacleData
-		{
-			float x;
-			float y;
-
-			float radius;
-		};
-
-		GameObstacleData m_gameObstacleData;
 };
 
 #endif
@@ -12,7 +12,13 @@
 #include "HighlightRequest.h"
 #include "PlayerProfile.h"
 #include "GameUnit.h"
+#include "GameState.h"
 #include "NewPlayerID.h"
+#include "ClockSync.h"
+#include "SelectionRequest.h"
+#include "ServerClock.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -21,8 +27,16 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+// The tolerance taps had when they were tested on the client
+const float GameServer::s_selectionRadius = 40.0f;
+
+////////////////////////////////////////////////////////////////////////////////
+
 void GameServer::run()
 {
+	// Let the game proceed on all available cores
+	m_threadPool = new ThreadPool;
+
 	m_gameNetworkServer = new GameNetworkServer();
 	m_gameNetworkServer->run();
 
@@ -35,13 +49,23 @@ void GameServer::run()
 	initializeMessageHandlers();
 
 	// Start the game server in a new thread
-	boost::thread gameServerThread(boost::bind(&GameServer::loop, this));
+	m_loopThread = boost::thread(boost::bind(&GameServer::loop, this));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameServer::initializeMessageHandlers()
 {
+	m_gameNetworkServer->addMessageHandler(
+		MESSAGE_SELECTION_REQUEST,
+		MESSAGE_ID_EVENT,
+		boost::bind(&GameServer::handleSelectionRequest, this, _1));
+
+	m_gameNetworkServer->addMessageHandler(
+		MESSAGE_CLOCK_SYNC,
+		MESSAGE_ID_EVENT,
+		boost::bind(&GameServer::handleClockSync, this, _1));
+
 	m_gameNetworkServer->addMessageHandler(
 		MESSAGE_MOVE_REQUEST,
 		MESSAGE_ID_EVENT,
@@ -57,6 +81,8 @@ void GameServer::initializeMessageHandlers()
 
 void GameServer::handleMoveRequest(MessageData messageData)
 {
+	PROFILE_SCOPE("server.handleMoveRequest");
+
 	MoveRequest moveRequest(NULL);
 	moveRequest.createFromData(messageData);
 
@@ -70,11 +96,25 @@ void GameServer::handleMoveRequest(MessageData messageData)
 		return;
 	}
 
-	GameUnitPtr matchingGameUnit;
+	GamePtr game = m_game;
 
-	if (m_game)
-		matchingGameUnit = m_game->unitByIndex(playerProfile->playerID(),
-											   moveRequest.unitIndex());
+	if (!game)
+		return;
+
+	// The units are only modified by the loop thread
+	game->post(boost::bind(&GameServer::moveUnit, this,
+		playerProfile->playerID(), moveRequest.unitIndex(),
+		GameUnit::requestedAcceleration(moveRequest.angle(),
+			moveRequest.strength()),
+		moveRequest.traceID(), moveRequest.inputSequence()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameServer::moveUnit(PlayerID playerID, uint8_t unitIndex,
+	cv::Vec2f acceleration, uint32_t traceID, uint32_t inputSequence)
+{
+	GameUnitPtr matchingGameUnit = m_game->unitByIndex(playerID, unitIndex);
 
 	if (!matchingGameUnit)
 	{
@@ -82,21 +122,35 @@ void GameServer::handleMoveRequest(MessageData messageData)
 		return;
 	}
 
-	float accelerationX = cos(moveRequest.angle());
-	float accelerationY = -sin(moveRequest.angle());
+	matchingGameUnit->setAcceleration(acceleration);
+
+	// Echo the trace and the input in the unit's state
+	matchingGameUnit->setTraceID(traceID);
+	matchingGameUnit->setInputSequence(inputSequence);
+}
 
-	float strength = std::min(1.0f, std::max(0.0f, moveRequest.strength()));
+////////////////////////////////////////////////////////////////////////////////
 
-	strength *= GameUnit::s_maximalAcceleration;
+void GameServer::handleClockSync(MessageData messageData)
+{
+	ClockSync clockSync(m_gameNetworkServer);
+	clockSync.createFromData(messageData);
 
-	matchingGameUnit->setAcceleration(cv::Vec2f(accelerationX, accelerationY)
-									  * strength);
+	if (!clockSync.isRequest())
+		return;
+
+	// Answer right away, so that the answer is close to halfway through the
+	// client's round trip
+	clockSync.setServerTime(ServerClock::now());
+	clockSync.synchronize(messageData.networkServerSession());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameServer::handleHighlightRequest(MessageData messageData)
 {
+	PROFILE_SCOPE("server.handleHighlightRequest");
+
 	HighlightRequest highlightRequest(NULL);
 	highlightRequest.createFromData(messageData);
 
@@ -110,11 +164,22 @@ void GameServer::handleHighlightRequest(MessageData messageData)
 		return;
 	}
 
-	GameUnitPtr matchingGameUnit;
+	GamePtr game = m_game;
 
-	if (m_game)
-		matchingGameUnit = m_game->unitByIndex(playerProfile->playerID(),
-											   highlightRequest.unitIndex());
+	if (!game)
+		return;
+
+	game->post(boost::bind(&GameServer::highlightUnit, this,
+		playerProfile->playerID(), highlightRequest.unitIndex(),
+		highlightRequest.isHighlighted()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameServer::highlightUnit(PlayerID playerID, uint8_t unitIndex,
+	bool isHighlighted)
+{
+	GameUnitPtr matchingGameUnit = m_game->unitByIndex(playerID, unitIndex);
 
 	if (!matchingGameUnit)
 	{
@@ -122,13 +187,104 @@ void GameServer::handleHighlightRequest(MessageData messageData)
 		return;
 	}
 
-	matchingGameUnit->setHighlighted(highlightRequest.isHighlighted());
+	matchingGameUnit->setHighlighted(isHighlighted);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameServer::handleSelectionRequest(MessageData messageData)
+{
+	PROFILE_SCOPE("server.handleSelectionRequest");
+
+	SelectionRequest selectionRequest(NULL);
+	selectionRequest.createFromData(messageData);
+
+	NetworkServerSession *session = messageData.networkServerSession();
+	PlayerProfilePtr playerProfile
+		= m_gameNetworkServer->playerProfileBySession(session);
+
+	if (!playerProfile)
+	{
+		Logging::error("Received selection request from non-player client.");
+		return;
+	}
+
+	GamePtr game = m_game;
+
+	if (!game)
+		return;
+
+	// Test against the units where the player saw them, not where they have
+	// moved to while the request was underway. The states are immutable, so
+	// this is safe on the network thread.
+	GameStatePtr gameState = selectionRequest.viewTime() != 0
+		? game->stateAt(selectionRequest.viewTime()) : game->state();
+
+	if (!gameState)
+		return;
+
+	PlayerID playerID = playerProfile->playerID();
+	cv::Point2f point = selectionRequest.point();
+
+	const GameUnitStates &units = gameState->units();
+	const GameUnitState *closestUnit = NULL;
+	float closestDistance = s_selectionRadius;
+
+	for (unsigned int i = 0; i < units.size(); i++)
+	{
+		if (units[i].owner != playerID)
+			continue;
+
+		float distance
+			= cv::norm(cv::Point2f(units[i].x, units[i].y) - point);
+
+		if (distance < closestDistance)
+		{
+			closestUnit = &units[i];
+			closestDistance = distance;
+		}
+	}
+
+	if (!closestUnit)
+		return;
+
+	game->post(boost::bind(&GameServer::toggleHighlight, this,
+		closestUnit->messageID));
+
+	std::stringstream message;
+	message << "Player " << playerID << " tapped unit no. "
+		<< (int)closestUnit->number << " (distance: " << closestDistance
+		<< ").";
+	Logging::info(message.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameServer::toggleHighlight(MessageID messageID)
+{
+	GameUnitPtr matchingGameUnit = m_game->unitByID(messageID);
+
+	if (!matchingGameUnit)
+		return;
+
+	matchingGameUnit->setHighlighted(!matchingGameUnit->isHighlighted());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameServer::stop()
 {
+	// The loop uses the thread pool and the network server
+	m_loopThread.interrupt();
+	m_loopThread.join();
+
+	if (m_game)
+		m_game->setThreadPool(NULL);
+
+	// Joins the worker threads
+	delete m_threadPool;
+	m_threadPool = NULL;
+
 	m_gameNetworkServer->stop();
 	delete m_gameNetworkServer;
 }
@@ -141,10 +297,23 @@ void GameServer::loop()
 	{
 		boost::this_thread::sleep(boost::posix_time::milliseconds(20));
 
-		if (m_game)
+		if (!m_game)
+			continue;
+
+		{
+			PROFILE_SCOPE("server.proceed");
 			m_game->proceed();
+		}
 
-		m_game->synchronize(ID_ALL_CLIENTS);
+		{
+			PROFILE_SCOPE("server.publishState");
+			m_game->publishState();
+		}
+
+		{
+			PROFILE_SCOPE("server.synchronize");
+			m_game->synchronize(ID_ALL_CLIENTS);
+		}
 	}
 }
 
@@ -170,14 +339,36 @@ void GameServer::handleSessionAccepted(NetworkServerSession *session)
 	newPlayerID.setPlayerID(playerProfile->playerID());
 	newPlayerID.synchronize(session);
 
-	m_game->synchronize(session);
+	GamePtr game = m_game;
+
+	if (!game)
+		return;
+
+	// Send the game as of the last step, read on the loop thread only
+	game->post(boost::bind(&GameServer::synchronizePlayer, this,
+		playerProfile->playerID()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameServer::synchronizePlayer(PlayerID playerID)
+{
+	m_game->synchronize(playerID);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameServer::handleSessionClosed(NetworkServerSession *session)
 {
+	PlayerProfilePtr playerProfile
+		= m_gameNetworkServer->playerProfileBySession(session);
+
+	if (!playerProfile)
+		return;
 
+	std::stringstream message;
+	message << "Player " << playerProfile->playerID() << " left the game.";
+	Logging::info(message.str());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -185,6 +376,8 @@ void GameServer::handleSessionClosed(NetworkServerSession *session)
 void GameServer::loadGame(int levelNumber)
 {
 	m_game = GamePtr(new Game(m_gameNetworkServer));
+	m_game->setThreadPool(m_threadPool);
+	m_game->setKeepingHistory(true);
 	m_game->load(levelNumber);
 }
 
@@ -3,6 +3,10 @@
 
 #include <vector>
 
+#include <boost/thread/thread.hpp>
+
+#include <opencv2/core/core.hpp>
+
 #include "MessageData.h"
 #include "ForwardDeclarations.h"
 
@@ -44,10 +48,23 @@ class GameServer
 		void startGame();
 
 	protected:
+		/** @brief Touches this close to a unit select it. */
+		static const float s_selectionRadius;
+
 		void initializeMessageHandlers();
 
 		void handleHighlightRequest(MessageData messageData);
 		void handleMoveRequest(MessageData messageData);
+		void handleClockSync(MessageData messageData);
+		void handleSelectionRequest(MessageData messageData);
+
+		// Apply the requests on the loop thread, posted by the handlers
+		void moveUnit(PlayerID playerID, uint8_t unitIndex,
+			cv::Vec2f acceleration, uint32_t traceID, uint32_t inputSequence);
+		void highlightUnit(PlayerID playerID, uint8_t unitIndex,
+			bool isHighlighted);
+		void toggleHighlight(MessageID messageID);
+		void synchronizePlayer(PlayerID playerID);
 
 		void processGame(float timeFactor);
 
@@ -59,6 +76,10 @@ class GameServer
 
 		GamePtr m_game;
 
+		ThreadPool *m_threadPool;
+
+		boost::thread m_loopThread;
+
 		PlayerProfiles m_players;
 };
 
@@ -0,0 +1,105 @@
+#include "GameState.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// GameUnitState
+//
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Point GameUnitState::position() const
+{
+	return cv::Point(x, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// GameObstacleState
+//
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Point GameObstacleState::position() const
+{
+	return cv::Point(x, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// GameState
+//
+////////////////////////////////////////////////////////////////////////////////
+
+GameState::GameState()
+{
+	m_ownPlayerID = ID_NONE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameState::addUnit(const GameUnitState &gameUnitState)
+{
+	PlayerID owner = gameUnitState.owner;
+
+	if (owner >= m_unitsByOwner.size())
+		m_unitsByOwner.resize(owner + 1);
+
+	m_unitsByOwner[owner].push_back(m_units.size());
+	m_units.push_back(gameUnitState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameState::addObstacle(const GameObstacleState &gameObstacleState)
+{
+	m_obstacles.push_back(gameObstacleState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameState::setOwnPlayerID(PlayerID ownPlayerID)
+{
+	m_ownPlayerID = ownPlayerID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PlayerID GameState::ownPlayerID() const
+{
+	return m_ownPlayerID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const GameUnitStates &GameState::units() const
+{
+	return m_units;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const GameObstacleStates &GameState::obstacles() const
+{
+	return m_obstacles;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const GameUnitState *GameState::unitByIndex(PlayerID playerID,
+	uint8_t index) const
+{
+	// Return no unit if accessing opponent's units
+	if (m_ownPlayerID != ID_NONE && m_ownPlayerID != playerID)
+		return NULL;
+
+	if (playerID >= m_unitsByOwner.size()
+		|| index >= m_unitsByOwner[playerID].size())
+		return NULL;
+
+	return &m_units[m_unitsByOwner[playerID][index]];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const GameUnitState *GameState::unitByIndex(uint8_t index) const
+{
+	return unitByIndex(m_ownPlayerID, index);
+}
@@ -0,0 +1,110 @@
+#ifndef __GAME_GAME_STATE_H
+#define __GAME_GAME_STATE_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "MessageData.h"
+#include "ForwardDeclarations.h"
+
+/**
+ * @struct GameUnitState
+ *
+ * @brief Copy of a game unit’s data at the time a game state was published.
+ */
+struct GameUnitState
+{
+	MessageID messageID;
+
+	float x;
+	float y;
+
+	uint8_t number;
+	PlayerID owner;
+
+	bool isHighlighted;
+	bool isLiving;
+	bool hasArrived;
+	bool isHunting;
+
+	/** @brief The trace of the last move request applied to the unit. */
+	uint32_t traceID;
+
+	/** @brief The motion, so that predictions can continue from a state. */
+	float velocityX;
+	float velocityY;
+	float accelerationX;
+	float accelerationY;
+
+	cv::Point position() const;
+};
+
+/**
+ * @struct GameObstacleState
+ *
+ * @brief Copy of a game obstacle’s data at the time a game state was
+ *     published.
+ */
+struct GameObstacleState
+{
+	MessageID messageID;
+
+	float x;
+	float y;
+
+	float radius;
+
+	cv::Point position() const;
+};
+
+/**
+ * @class GameState
+ *
+ * @brief Consistent snapshot of the whole game world.
+ *
+ * A game state is built by the thread modifying the game and then published
+ * as a whole. Once published, it is never modified again, so that rendering
+ * and input handling can read it from any thread without locking.
+ */
+class GameState
+{
+	public:
+		GameState();
+
+		void addUnit(const GameUnitState &gameUnitState);
+		void addObstacle(const GameObstacleState &gameObstacleState);
+
+		void setOwnPlayerID(PlayerID ownPlayerID);
+		PlayerID ownPlayerID() const;
+
+		const GameUnitStates &units() const;
+		const GameObstacleStates &obstacles() const;
+
+		/**
+		 * @brief Returns the n-th unit of a player.
+		 *
+		 * Returns the unit with the given index among all units owned by the
+		 * given player. Opponent’s units cannot be accessed if the own player
+		 * ID is known.
+		 *
+		 * @param playerID - The owner of the unit.
+		 * @param index - The index of the unit among the player’s units.
+		 *
+		 * @return The unit’s state or NULL if there is no such unit.
+		 */
+		const GameUnitState *unitByIndex(PlayerID playerID, uint8_t index) const;
+
+		const GameUnitState *unitByIndex(uint8_t index) const;
+
+	protected:
+		GameUnitStates m_units;
+		GameObstacleStates m_obstacles;
+
+		// Positions in m_units of each player's units, by player ID
+		std::vector<std::vector<int> > m_unitsByOwner;
+
+		PlayerID m_ownPlayerID;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "GameStateBuffer.h"
+
+#include "GameState.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// GameStateBuffer
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Well below the 20 ms between two steps of the server
+const boost::chrono::milliseconds GameStateBuffer::s_mergeDuration(5);
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStateBuffer::GameStateBuffer()
+{
+	m_newest = 0;
+	m_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameStateBuffer::add(const GameStatePtr &gameState,
+	Clock::time_point time)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	// Merge the updates of one server step, keeping the time of the first
+	if (m_count > 0 && time - m_snapshots[m_newest].time < s_mergeDuration)
+	{
+		m_snapshots[m_newest].gameState = gameState;
+		return;
+	}
+
+	m_newest = (m_newest + 1) % CAPACITY;
+	m_snapshots[m_newest].gameState = gameState;
+	m_snapshots[m_newest].time = time;
+
+	if (m_count < CAPACITY)
+		m_count++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStatePtr GameStateBuffer::interpolate(Clock::time_point time) const
+{
+	Snapshot older;
+	Snapshot newer;
+
+	{
+		boost::lock_guard<boost::mutex> lock(m_mutex);
+
+		if (m_count == 0)
+			return GameStatePtr();
+
+		if (time >= snapshot(0).time)
+			return snapshot(0).gameState;
+
+		// Find the newest snapshot not after the given time
+		int age = 1;
+
+		while (age < m_count && snapshot(age).time > time)
+			age++;
+
+		if (age == m_count)
+			return snapshot(m_count - 1).gameState;
+
+		older = snapshot(age);
+		newer = snapshot(age - 1);
+	}
+
+	// Blend outside the lock, the states themselves are immutable
+	float weight = boost::chrono::duration<float>(time - older.time).count()
+		/ boost::chrono::duration<float>(newer.time - older.time).count();
+
+	return blend(*older.gameState, *newer.gameState, weight);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameStateBuffer::clear()
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	for (int i = 0; i < CAPACITY; i++)
+		m_snapshots[i].gameState = GameStatePtr();
+
+	m_count = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStatePtr GameStateBuffer::blend(const GameState &older,
+	const GameState &newer, float weight)
+{
+	GameState *gameState = new GameState;
+	gameState->setOwnPlayerID(newer.ownPlayerID());
+
+	for (unsigned int i = 0; i < newer.obstacles().size(); i++)
+		gameState->addObstacle(newer.obstacles()[i]);
+
+	const GameUnitStates &olderUnits = older.units();
+	const GameUnitStates &newerUnits = newer.units();
+
+	for (unsigned int i = 0; i < newerUnits.size(); i++)
+	{
+		GameUnitState unit = newerUnits[i];
+
+		// Units are only ever appended, so they usually are at the same index
+		const GameUnitState *olderUnit = NULL;
+
+		if (i < olderUnits.size() && olderUnits[i].messageID == unit.messageID)
+			olderUnit = &olderUnits[i];
+		else
+			for (unsigned int j = 0; j < olderUnits.size(); j++)
+				if (olderUnits[j].messageID == unit.messageID)
+				{
+					olderUnit = &olderUnits[j];
+					break;
+				}
+
+		// Units not known yet appear at their first received position
+		if (olderUnit)
+		{
+			unit.x = olderUnit->x + (unit.x - olderUnit->x) * weight;
+			unit.y = olderUnit->y + (unit.y - olderUnit->y) * weight;
+		}
+
+		gameState->addUnit(unit);
+	}
+
+	return GameStatePtr(gameState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const GameStateBuffer::Snapshot &GameStateBuffer::snapshot(int age) const
+{
+	return m_snapshots[(m_newest - age + CAPACITY) % CAPACITY];
+}
@@ -0,0 +1,101 @@
+#ifndef __GAME_GAME_STATE_BUFFER_H
+#define __GAME_GAME_STATE_BUFFER_H
+
+#include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "ForwardDeclarations.h"
+
+/**
+ * @class GameStateBuffer
+ *
+ * @brief Ring of recently received game states for interpolation.
+ *
+ * Keeps the last game states together with the time they were received. A
+ * state can then be computed for any time in between by interpolating the unit
+ * positions of the two states enclosing it, so that units move smoothly no
+ * matter how server updates and rendered frames are spaced.
+ *
+ * The server sends all units of a step at once. States received within a few
+ * milliseconds are therefore merged into one, so that each entry of the ring
+ * corresponds to one step of the server.
+ */
+class GameStateBuffer
+{
+	public:
+		typedef boost::chrono::steady_clock Clock;
+
+		GameStateBuffer();
+
+		/**
+		 * @brief Adds a received game state.
+		 *
+		 * @param gameState - The state to add.
+		 * @param time - When the state has been received.
+		 */
+		void add(const GameStatePtr &gameState, Clock::time_point time);
+
+		/**
+		 * @brief Returns the game state at a given time.
+		 *
+		 * Interpolates the positions of the units between the two states
+		 * enclosing the given time. Before the oldest or after the newest
+		 * state, that state is returned unchanged.
+		 *
+		 * @param time - The time to compute the state for.
+		 * @return The state or NULL if no state has been added yet.
+		 */
+		GameStatePtr interpolate(Clock::time_point time) const;
+
+		/**
+		 * @brief Removes all states.
+		 */
+		void clear();
+
+	protected:
+		/** @brief Number of states kept, covering about 300 ms. */
+		enum {CAPACITY = 16};
+
+		/** @brief States received within this duration are merged. */
+		static const boost::chrono::milliseconds s_mergeDuration;
+
+		/**
+		 * @struct Snapshot
+		 *
+		 * @brief A game state and the time it has been received.
+		 */
+		struct Snapshot
+		{
+			GameStatePtr gameState;
+			Clock::time_point time;
+		};
+
+		/**
+		 * @brief Blends the unit positions of two states.
+		 *
+		 * Everything but the positions is taken from the newer state.
+		 *
+		 * @param older - The older state.
+		 * @param newer - The newer state.
+		 * @param weight - The weight of the newer state between 0 and 1.
+		 * @return The blended state.
+		 */
+		static GameStatePtr blend(const GameState &older,
+			const GameState &newer, float weight);
+
+		/** @brief The snapshot at the given age, 0 being the newest. */
+		const Snapshot &snapshot(int age) const;
+
+		Snapshot m_snapshots[CAPACITY];
+
+		/** @brief Index of the newest snapshot. */
+		int m_newest;
+
+		/** @brief Number of valid snapshots. */
+		int m_count;
+
+		/** @brief Mutex between the network and the rendering thread. */
+		mutable boost::mutex m_mutex;
+};
+
+#endif
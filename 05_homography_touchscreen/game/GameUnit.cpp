@@ -9,6 +9,8 @@
 
 #include "GameNetworkInterface.h"
 #include "GameObstacle.h"
+#include "GameState.h"
+#include "LatencyTracer.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -25,82 +27,111 @@ float GameUnit::s_radius = 8.0f;
 ////////////////////////////////////////////////////////////////////////////////
 
 GameUnit::GameUnit(GameNetworkInterface *gameNetworkInterface)
-	: Message(gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
 {
-	// Set up unit data for network transmission via messages
-	registerMessageType(MESSAGE_GAME_UNIT, &m_gameUnitData,
-		sizeof(GameUnitData), UPDATE_FREQUENCY_ALWAYS);
-
-	m_velocity = cv::Vec2f(0.0f, 0.0f);
-	m_acceleration = cv::Vec2f(0.0f, 0.0f);
+	setVelocity(cv::Vec2f(0.0f, 0.0f));
+	setAcceleration(cv::Vec2f(0.0f, 0.0f));
+	setInputSequence(0);
+	setServerTime(0, 0);
 
 	setLiving(true);
+	setHunting(false);
 	setArrived(false);
 	setHighlighted(false);
+	setTraceID(0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void GameUnit::render(cv::Mat &image)
+void GameUnit::render(cv::Mat &image, const GameUnitState &gameUnitState)
 {
+	const GameUnitState &unit = gameUnitState;
+
 	cv::Scalar color;
 
-	if (hasArrived())
+	if (unit.hasArrived)
 		color = cv::Scalar(255, 255, 255);
-	else if (!isLiving())
+	else if (!unit.isLiving)
 		color = cv::Scalar(0, 0, 0);
-	else if (owner() == ID_FIRST_CLIENT)
+	else if (unit.owner == ID_FIRST_CLIENT)
 		color = cv::Scalar(192, 160, 0);
 	else
 		color = cv::Scalar(0, 64, 192);
 
-	if (isHighlighted() && isLiving() && !hasArrived())
-		cv::circle(image, cv::Point(x(), y()), s_radius + 4, cv::Scalar(224, 224, 224), CV_FILLED, CV_AA);
+	if (unit.isHighlighted && unit.isLiving && !unit.hasArrived)
+		cv::circle(image, cv::Point(unit.x, unit.y), s_radius + 4, cv::Scalar(224, 224, 224), CV_FILLED, CV_AA);
 
-	cv::circle(image, cv::Point(x(), y()), s_radius, color, CV_FILLED, CV_AA);
+	cv::circle(image, cv::Point(unit.x, unit.y), s_radius, color, CV_FILLED, CV_AA);
 
 	std::stringstream numberText;
-	numberText << (int)number();
+	numberText << (int)unit.number;
 
 	cv::putText(image, numberText.str(),
-				cv::Point(x() - s_radius / 2, y() + s_radius / 2),
+				cv::Point(unit.x - s_radius / 2, unit.y + s_radius / 2),
 				cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255), 1.25,
 				CV_AA);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+GameUnitState GameUnit::state() const
+{
+	GameUnitState gameUnitState;
+	gameUnitState.messageID = messageID();
+	gameUnitState.x = m_data.x;
+	gameUnitState.y = m_data.y;
+	gameUnitState.number = m_data.number;
+	gameUnitState.owner = m_data.owner;
+	gameUnitState.isHighlighted = m_data.isHighlighted;
+	gameUnitState.isLiving = m_data.isLiving;
+	gameUnitState.hasArrived = m_data.hasArrived;
+	gameUnitState.isHunting = m_isHunting;
+	gameUnitState.traceID = m_data.traceID;
+	gameUnitState.velocityX = m_data.velocityX;
+	gameUnitState.velocityY = m_data.velocityY;
+	gameUnitState.accelerationX = m_data.accelerationX;
+	gameUnitState.accelerationY = m_data.accelerationY;
+
+	return gameUnitState;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void GameUnit::move(float timeDifference)
 {
 	if (!isLiving() || hasArrived())
 	{
-		m_velocity = cv::Vec2f(0.0f, 0.0f);
-		m_acceleration = cv::Vec2f(0.0f, 0.0f);
+		setVelocity(cv::Vec2f(0.0f, 0.0f));
+		setAcceleration(cv::Vec2f(0.0f, 0.0f));
 
 		return;
 	}
 
+	cv::Vec2f velocity = this->velocity();
+
 	// Brake the object slightly
-	cv::Vec2f acceleration = m_acceleration - m_velocity * s_brakeFactor;
+	cv::Vec2f acceleration = this->acceleration() - velocity * s_brakeFactor;
 
-	m_velocity += acceleration * timeDifference;
+	velocity += acceleration * timeDifference;
 
 	// If the speed exceeds the maximal speed, reset the speed to the maximum
-	float velocityNorm = cv::norm(m_velocity);
+	float velocityNorm = cv::norm(velocity);
 
 	if (velocityNorm > s_maximalVelocity)
-		m_velocity *= s_maximalVelocity / velocityNorm;
+		velocity *= s_maximalVelocity / velocityNorm;
+
+	setVelocity(velocity);
 
-	m_gameUnitData.x += m_velocity[0] * timeDifference;
-	m_gameUnitData.y += m_velocity[1] * timeDifference;
+	m_data.x += velocity[0] * timeDifference;
+	m_data.y += velocity[1] * timeDifference;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameUnit::setPosition(float x, float y)
 {
-	m_gameUnitData.x = x;
-	m_gameUnitData.y = y;
+	m_data.x = x;
+	m_data.y = y;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -114,70 +145,70 @@ cv::Point GameUnit::position() const
 
 float GameUnit::x() const
 {
-	return m_gameUnitData.x;
+	return m_data.x;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float &GameUnit::x()
 {
-	return m_gameUnitData.x;
+	return m_data.x;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float GameUnit::y() const
 {
-	return m_gameUnitData.y;
+	return m_data.y;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float &GameUnit::y()
 {
-	return m_gameUnitData.y;
+	return m_data.y;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameUnit::setNumber(uint8_t number)
 {
-	m_gameUnitData.number = number;
+	m_data.number = number;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 uint8_t GameUnit::number()
 {
-	return m_gameUnitData.number;
+	return m_data.number;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameUnit::setOwner(PlayerID owner)
 {
-	m_gameUnitData.owner = owner;
+	m_data.owner = owner;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 PlayerID GameUnit::owner() const
 {
-	return m_gameUnitData.owner;
+	return m_data.owner;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameUnit::setLiving(bool isLiving)
 {
-	m_gameUnitData.isLiving = isLiving;
+	m_data.isLiving = isLiving;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 bool GameUnit::isLiving() const
 {
-	return m_gameUnitData.isLiving;
+	return m_data.isLiving;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -198,35 +229,152 @@ bool GameUnit::isHunting() const
 
 void GameUnit::setHighlighted(bool isHighlighted)
 {
-	m_gameUnitData.isHighlighted = isHighlighted;
+	m_data.isHighlighted = isHighlighted;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 bool GameUnit::isHighlighted() const
 {
-	return m_gameUnitData.isHighlighted;
+	return m_data.isHighlighted;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameUnit::setArrived(bool hasArrived)
 {
-	m_gameUnitData.hasArrived = hasArrived;
+	m_data.hasArrived = hasArrived;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 bool GameUnit::hasArrived() const
 {
-	return m_gameUnitData.hasArrived;
+	return m_data.hasArrived;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::setVelocity(cv::Vec2f velocity)
+{
+	m_data.velocityX = velocity[0];
+	m_data.velocityY = velocity[1];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Vec2f GameUnit::velocity() const
+{
+	return cv::Vec2f(m_data.velocityX, m_data.velocityY);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void GameUnit::setAcceleration(cv::Vec2f acceleration)
 {
-	m_acceleration = acceleration;
+	m_data.accelerationX = acceleration[0];
+	m_data.accelerationY = acceleration[1];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Vec2f GameUnit::acceleration() const
+{
+	return cv::Vec2f(m_data.accelerationX, m_data.accelerationY);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Vec2f GameUnit::requestedAcceleration(float angle, float strength)
+{
+	strength = std::min(1.0f, std::max(0.0f, strength));
+
+	return cv::Vec2f(cos(angle), -sin(angle)) * strength
+		* s_maximalAcceleration;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::setInputSequence(uint32_t inputSequence)
+{
+	m_data.inputSequence = inputSequence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GameUnit::inputSequence() const
+{
+	return m_data.inputSequence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::setServerTime(uint32_t serverTick, boost::int64_t serverTime)
+{
+	m_data.serverTick = serverTick;
+	m_data.serverTime = serverTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GameUnit::serverTick() const
+{
+	return m_data.serverTick;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::int64_t GameUnit::serverTime() const
+{
+	return m_data.serverTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::adoptState(const GameUnit &gameUnit)
+{
+	m_data = gameUnit.m_data;
+	m_isHunting = gameUnit.m_isHunting;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::adoptState(const GameUnitState &gameUnitState)
+{
+	m_data.x = gameUnitState.x;
+	m_data.y = gameUnitState.y;
+	m_data.number = gameUnitState.number;
+	m_data.owner = gameUnitState.owner;
+	m_data.isHighlighted = gameUnitState.isHighlighted;
+	m_data.isLiving = gameUnitState.isLiving;
+	m_data.hasArrived = gameUnitState.hasArrived;
+	m_data.traceID = gameUnitState.traceID;
+	m_data.velocityX = gameUnitState.velocityX;
+	m_data.velocityY = gameUnitState.velocityY;
+	m_data.accelerationX = gameUnitState.accelerationX;
+	m_data.accelerationY = gameUnitState.accelerationY;
+	m_isHunting = gameUnitState.isHunting;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::setTraceID(uint32_t traceID)
+{
+	m_data.traceID = traceID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GameUnit::traceID() const
+{
+	return m_data.traceID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::traceUpdate()
+{
+	LatencyTracer::instance()->markReceived(m_data.traceID);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -249,11 +397,11 @@ bool GameUnit::collidesWith(const GameUnit &otherGameUnit)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool GameUnit::collidesWith(const GameObstacle &gameObstacle)
+bool GameUnit::collidesWith(const GameObstacleState &gameObstacle)
 {
 	float distance = cv::norm(position() - gameObstacle.position());
 
-	if (distance < s_radius + gameObstacle.radius())
+	if (distance < s_radius + gameObstacle.radius)
 		return true;
 
 	return false;
@@ -261,14 +409,14 @@ bool GameUnit::collidesWith(const GameObstacle &gameObstacle)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void GameUnit::separateFrom(const GameObstacle &gameObstacle)
+void GameUnit::separateFrom(const GameObstacleState &gameObstacle)
 {
 	reflectOn(gameObstacle);
 
 	cv::Point2f direction = position() - gameObstacle.position();
 	float distance = cv::norm(direction);
 
-	float overlappingDistance = distance - (s_radius + gameObstacle.radius());
+	float overlappingDistance = distance - (s_radius + gameObstacle.radius);
 
 	if (overlappingDistance <= 0)
 		return;
@@ -284,21 +432,23 @@ void GameUnit::separateFrom(const GameObstacle &gameObstacle)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void GameUnit::reflectOn(const GameObstacle &gameObstacle)
+void GameUnit::reflectOn(const GameObstacleState &gameObstacle)
 {
 	// Compute the axes of collision
 	cv::Point2f axis1 = position() - gameObstacle.position();
 
 	axis1 = axis1 * (1.0f / norm(axis1));
 
+	cv::Vec2f velocity = this->velocity();
+
 	// Project the velocities of both objects to the axes in order to obtain the
 	// velocity amount in the direction of collision
-	float initialSpeedOnAxis1 = m_velocity.dot(axis1);
+	float initialSpeedOnAxis1 = velocity.dot(axis1);
 
 	// Delete the speed component in the direction of collision. Later, we will
 	// add back the new speed component that has changed due to collision
-	m_velocity[0] -= axis1.x * initialSpeedOnAxis1;
-	m_velocity[1] -= axis1.y * initialSpeedOnAxis1;
+	velocity[0] -= axis1.x * initialSpeedOnAxis1;
+	velocity[1] -= axis1.y * initialSpeedOnAxis1;
 
 	// Compute the speed component after collision
 	float finalSpeedOnAxis1;
@@ -306,8 +456,10 @@ void GameUnit::reflectOn(const GameObstacle &gameObstacle)
 	finalSpeedOnAxis1 = -initialSpeedOnAxis1;
 
 	// Add as much speed in the direction of collision as we previously computed
-	m_velocity[0] += axis1.x * fabs(finalSpeedOnAxis1);
-	m_velocity[1] += axis1.y * fabs(finalSpeedOnAxis1);
+	velocity[0] += axis1.x * fabs(finalSpeedOnAxis1);
+	velocity[1] += axis1.y * fabs(finalSpeedOnAxis1);
+
+	setVelocity(velocity);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -318,27 +470,63 @@ void GameUnit::reflectOnWalls()
 	{
 		x() = s_radius / 2;
 
-		m_velocity[0] = -m_velocity[0];
+		m_data.velocityX = -m_data.velocityX;
 	}
 
 	if (x() > 480 - s_radius / 2)
 	{
 		x() = 480 - s_radius / 2;
 
-		m_velocity[0] = -m_velocity[0];
+		m_data.velocityX = -m_data.velocityX;
 	}
 
 	if (y() < s_radius / 2)
 	{
 		y() = s_radius / 2;
 
-		m_velocity[1] = -m_velocity[1];
+		m_data.velocityY = -m_data.velocityY;
 	}
 
 	if (y() > 480 - s_radius / 2)
 	{
 		y() = 480 - s_radius / 2;
 
-		m_velocity[1] = -m_velocity[1];
+		m_data.velocityY = -m_data.velocityY;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::simulate(float timeDifference,
+	const GameObstacles &gameObstacles)
+{
+	move(timeDifference);
+	reflectOnWalls();
+
+	for (unsigned int i = 0; i < gameObstacles.size(); i++)
+	{
+		GameObstacleState gameObstacle = gameObstacles[i]->state();
+
+		if (!collidesWith(gameObstacle))
+			continue;
+
+		separateFrom(gameObstacle);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GameUnit::simulate(float timeDifference,
+	const GameObstacleStates &gameObstacles)
+{
+	move(timeDifference);
+	reflectOnWalls();
+
+	for (unsigned int i = 0; i < gameObstacles.size(); i++)
+	{
+		if (!collidesWith(gameObstacles[i]))
+			continue;
+
+		separateFrom(gameObstacles[i]);
 	}
 }
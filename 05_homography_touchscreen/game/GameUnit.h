@@ -2,14 +2,43 @@
 #define __GAME_GAME_UNIT_H
 
 #include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
-#include "Message.h"
+#include "MessageSchema.h"
+#include "MessageTypes.h"
 #include "MessageData.h"
 #include "ForwardDeclarations.h"
 
-class GameUnit : public Message
+// Data to synchronize via network
+struct GameUnitData
+{
+	float x;
+	float y;
+
+	uint8_t number;
+	PlayerID owner;
+
+	bool isHighlighted;
+	bool isLiving;
+	bool hasArrived;
+
+	uint32_t traceID;
+
+	float velocityX;
+	float velocityY;
+	float accelerationX;
+	float accelerationY;
+
+	uint32_t inputSequence;
+
+	uint32_t serverTick;
+	boost::int64_t serverTime;
+};
+
+class GameUnit : public MessageSchema<MESSAGE_GAME_UNIT, GameUnitData,
+	UPDATE_FREQUENCY_ALWAYS>
 {
 	public:
 		static float s_maximalVelocity;
@@ -20,7 +49,9 @@ class GameUnit : public Message
 	public:
 		GameUnit(GameNetworkInterface *gameNetworkInterface);
 
-		void render(cv::Mat &image);
+		static void render(cv::Mat &image, const GameUnitState &gameUnitState);
+
+		GameUnitState state() const;
 
 		void move(float timeDifference);
 
@@ -49,37 +80,52 @@ class GameUnit : public Message
 		void setHighlighted(bool isHighlighted = true);
 		bool isHighlighted() const;
 
+		void setVelocity(cv::Vec2f velocity);
+		cv::Vec2f velocity() const;
+
 		void setAcceleration(cv::Vec2f acceleration);
+		cv::Vec2f acceleration() const;
 
-		bool collidesWith(const GameUnit &otherGameUnit);
-		bool collidesWith(const GameObstacle &gameObstacle);
+		// The acceleration a move request with the given angle and strength
+		// applies to a unit
+		static cv::Vec2f requestedAcceleration(float angle, float strength);
 
-		void separateFrom(const GameObstacle &gameObstacle);
-		void reflectOn(const GameObstacle &gameObstacle);
+		// The sequence number of the last move request applied to the unit
+		void setInputSequence(uint32_t inputSequence);
+		uint32_t inputSequence() const;
 
-		void reflectOnWalls();
+		// The step of the server and the server time the state belongs to
+		void setServerTime(uint32_t serverTick, boost::int64_t serverTime);
+		uint32_t serverTick() const;
+		boost::int64_t serverTime() const;
 
-	protected:
-		// Data to synchronize via network
-		struct GameUnitData
-		{
-			float x;
-			float y;
+		// Copies the whole state of another unit except for its message ID
+		void adoptState(const GameUnit &gameUnit);
+		void adoptState(const GameUnitState &gameUnitState);
 
-			uint8_t number;
-			PlayerID owner;
+		// The trace of the last move request applied to the unit
+		void setTraceID(uint32_t traceID);
+		uint32_t traceID() const;
 
-			bool isHighlighted;
-			bool isLiving;
-			bool hasArrived;
-		};
+		// Passes the trace of a received update on to the latency tracer
+		void traceUpdate();
 
-		cv::Vec2f m_velocity;
-		cv::Vec2f m_acceleration;
+		bool collidesWith(const GameUnit &otherGameUnit);
+		bool collidesWith(const GameObstacleState &gameObstacle);
 
-		bool m_isHunting;
+		void separateFrom(const GameObstacleState &gameObstacle);
+		void reflectOn(const GameObstacleState &gameObstacle);
 
-		GameUnitData m_gameUnitData;
+		void reflectOnWalls();
+
+		// Moves the unit and resolves collisions with the walls and the
+		// obstacles, the same way on the server and for client predictions
+		void simulate(float timeDifference, const GameObstacles &gameObstacles);
+		void simulate(float timeDifference,
+			const GameObstacleStates &gameObstacles);
+
+	protected:
+		bool m_isHunting;
 };
 
 #endif
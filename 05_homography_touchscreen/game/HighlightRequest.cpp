@@ -11,13 +11,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 HighlightRequest::HighlightRequest(GameNetworkInterface *gameNetworkInterface)
-	: Message(gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
 {
-	m_networkData.isHighlighted = true;
-
-	// Set up for network transmission via messages
-	registerMessageType(MESSAGE_HIGHLIGHT_REQUEST, &m_networkData,
-		sizeof(NetworkData), UPDATE_FREQUENCY_ONCE);
+	m_data.isHighlighted = true;
 
 	setMessageID(MESSAGE_ID_EVENT);
 }
@@ -26,26 +22,26 @@ HighlightRequest::HighlightRequest(GameNetworkInterface *gameNetworkInterface)
 
 void HighlightRequest::setUnitIndex(uint8_t unitIndex)
 {
-	m_networkData.unitIndex = unitIndex;
+	m_data.unitIndex = unitIndex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 uint8_t HighlightRequest::unitIndex()
 {
-	return m_networkData.unitIndex;
+	return m_data.unitIndex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void HighlightRequest::setHighlighted(bool isHighlighted)
 {
-	m_networkData.isHighlighted = isHighlighted;
+	m_data.isHighlighted = isHighlighted;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 bool HighlightRequest::isHighlighted()
 {
-	return m_networkData.isHighlighted;
+	return m_data.isHighlighted;
 }
@@ -1,10 +1,19 @@
 #ifndef __GAME_HIGHLIGHTREQUEST_H
 #define __GAME_HIGHLIGHTREQUEST_H
 
-#include "Message.h"
+#include "MessageSchema.h"
+#include "MessageTypes.h"
 #include "ForwardDeclarations.h"
 
-class HighlightRequest : public Message
+// Data to synchronize via network
+struct HighlightRequestData
+{
+	uint8_t unitIndex;
+	bool isHighlighted;
+};
+
+class HighlightRequest : public MessageSchema<MESSAGE_HIGHLIGHT_REQUEST,
+	HighlightRequestData, UPDATE_FREQUENCY_ONCE>
 {
 	public:
 		HighlightRequest(GameNetworkInterface *gameNetworkInterface);
@@ -14,15 +23,6 @@ class HighlightRequest : public Message
 
 		void setHighlighted(bool isHighlighted = true);
 		bool isHighlighted();
-
-	protected:
-		struct NetworkData
-		{
-			uint8_t unitIndex;
-			bool isHighlighted;
-		};
-
-		NetworkData m_networkData;
 };
 
 #endif
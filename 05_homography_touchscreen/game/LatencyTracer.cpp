@@ -0,0 +1,161 @@
+#include "LatencyTracer.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// LatencyTracer
+//
+////////////////////////////////////////////////////////////////////////////////
+
+LatencyTracer *LatencyTracer::s_instance = NULL;
+
+////////////////////////////////////////////////////////////////////////////////
+
+LatencyTracer *LatencyTracer::instance()
+{
+	if (!s_instance)
+		s_instance = new LatencyTracer;
+
+	return s_instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LatencyTracer::LatencyTracer()
+{
+	m_nextTraceID = 1;
+	m_isEnabled = false;
+
+	Profiler *profiler = Profiler::instance();
+	m_captureToSentStage = profiler->stage("latency.captureToSent");
+	m_sentToReceivedStage = profiler->stage("latency.sentToReceived");
+	m_receivedToDisplayedStage = profiler->stage("latency.receivedToDisplayed");
+	m_endToEndStage = profiler->stage("latency.endToEnd");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyTracer::setEnabled(bool isEnabled)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	m_isEnabled = isEnabled;
+
+	if (!m_isEnabled)
+		m_traces.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LatencyTracer::isEnabled() const
+{
+	return m_isEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t LatencyTracer::beginTrace(Clock::time_point captureTime)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	if (!m_isEnabled)
+		return 0;
+
+	removeStaleTraces(Clock::now());
+
+	uint32_t traceID = m_nextTraceID++;
+
+	// 0 means no trace
+	if (m_nextTraceID == 0)
+		m_nextTraceID = 1;
+
+	Trace &trace = m_traces[traceID];
+	trace.captureTime = captureTime;
+	trace.isSent = false;
+	trace.isReceived = false;
+
+	return traceID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyTracer::markSent(uint32_t traceID)
+{
+	if (traceID == 0)
+		return;
+
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	Traces::iterator trace = m_traces.find(traceID);
+
+	if (trace == m_traces.end() || (*trace).second.isSent)
+		return;
+
+	(*trace).second.sentTime = Clock::now();
+	(*trace).second.isSent = true;
+
+	Profiler::instance()->record(m_captureToSentStage,
+		(*trace).second.sentTime - (*trace).second.captureTime);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyTracer::markReceived(uint32_t traceID)
+{
+	if (traceID == 0)
+		return;
+
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	Traces::iterator trace = m_traces.find(traceID);
+
+	if (trace == m_traces.end() || !(*trace).second.isSent
+		|| (*trace).second.isReceived)
+		return;
+
+	(*trace).second.receivedTime = Clock::now();
+	(*trace).second.isReceived = true;
+
+	Profiler::instance()->record(m_sentToReceivedStage,
+		(*trace).second.receivedTime - (*trace).second.sentTime);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyTracer::markDisplayed(uint32_t traceID)
+{
+	if (traceID == 0)
+		return;
+
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	Traces::iterator trace = m_traces.find(traceID);
+
+	if (trace == m_traces.end() || !(*trace).second.isReceived)
+		return;
+
+	Clock::time_point displayedTime = Clock::now();
+
+	Profiler::instance()->record(m_receivedToDisplayedStage,
+		displayedTime - (*trace).second.receivedTime);
+	Profiler::instance()->record(m_endToEndStage,
+		displayedTime - (*trace).second.captureTime);
+
+	m_traces.erase(trace);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LatencyTracer::removeStaleTraces(Clock::time_point now)
+{
+	// Keep the map small, stale traces are rare compared to new ones
+	if (m_traces.size() < 256)
+		return;
+
+	for (Traces::iterator trace = m_traces.begin(); trace != m_traces.end();)
+	{
+		if (now - (*trace).second.captureTime > boost::chrono::seconds(2))
+			m_traces.erase(trace++);
+		else
+			trace++;
+	}
+}
@@ -0,0 +1,123 @@
+#ifndef __GENERAL_LATENCY_TRACER_H
+#define __GENERAL_LATENCY_TRACER_H
+
+#include <map>
+
+#include <boost/chrono.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "MessageData.h"
+#include "Profiler.h"
+
+/**
+ * @class LatencyTracer
+ *
+ * @brief Measures the latency from capturing an input to displaying its
+ *     effect.
+ *
+ * Each move request carries a trace ID, which the server copies into the
+ * state of the unit being moved. The client follows the trace from the
+ * camera frame through sending the request and receiving the unit’s update
+ * to displaying the updated unit. All times are taken on the client, so the
+ * clocks of client and server need not be synchronized. The latencies of the
+ * individual hops are recorded as profiler stages.
+ */
+class LatencyTracer : private boost::noncopyable
+{
+	public:
+		typedef boost::chrono::steady_clock Clock;
+
+		/**
+		 * @brief Returns the latency tracer singleton.
+		 *
+		 * @return The singleton instance of the latency tracer.
+		 */
+		static LatencyTracer *instance();
+
+		/**
+		 * @brief Enables or disables tracing.
+		 *
+		 * Traces are only started while tracing is enabled.
+		 *
+		 * @param isEnabled - Whether to start new traces.
+		 */
+		void setEnabled(bool isEnabled);
+		bool isEnabled() const;
+
+		/**
+		 * @brief Starts tracing an input.
+		 *
+		 * @param captureTime - The time the camera frame containing the input
+		 *     was captured.
+		 *
+		 * @return The ID of the new trace or 0 if tracing is disabled.
+		 */
+		uint32_t beginTrace(Clock::time_point captureTime);
+
+		/**
+		 * @brief Notes that the request of a trace has been sent.
+		 *
+		 * @param traceID - The trace of the request.
+		 */
+		void markSent(uint32_t traceID);
+
+		/**
+		 * @brief Notes that a unit update carrying a trace has been received.
+		 *
+		 * Only the first update carrying the trace is taken into account.
+		 *
+		 * @param traceID - The trace echoed by the unit.
+		 */
+		void markReceived(uint32_t traceID);
+
+		/**
+		 * @brief Notes that a unit carrying a trace has been displayed.
+		 *
+		 * Finishes the trace.
+		 *
+		 * @param traceID - The trace echoed by the unit.
+		 */
+		void markDisplayed(uint32_t traceID);
+
+	protected:
+		LatencyTracer();
+
+		/** @brief The singleton instance of the latency tracer. */
+		static LatencyTracer *s_instance;
+
+		struct Trace
+		{
+			Clock::time_point captureTime;
+			Clock::time_point sentTime;
+			Clock::time_point receivedTime;
+
+			bool isSent;
+			bool isReceived;
+		};
+
+		typedef std::map<uint32_t, Trace> Traces;
+
+		void removeStaleTraces(Clock::time_point now);
+
+		/**
+		 * @brief The traces not displayed yet.
+		 *
+		 * Most traces are never displayed, because the server overwrites
+		 * them with newer ones before the next update is sent.
+		 */
+		Traces m_traces;
+
+		uint32_t m_nextTraceID;
+		bool m_isEnabled;
+
+		Profiler::StageID m_captureToSentStage;
+		Profiler::StageID m_sentToReceivedStage;
+		Profiler::StageID m_receivedToDisplayedStage;
+		Profiler::StageID m_endToEndStage;
+
+		/** @brief Mutex protecting the traces. */
+		boost::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "LocalServerSession.h"
+
+#include <boost/bind.hpp>
+
+#include "GameNetworkClient.h"
+#include "Logging.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// LocalServerSession
+//
+////////////////////////////////////////////////////////////////////////////////
+
+LocalServerSession::LocalServerSession(boost::asio::io_service &ioService,
+	GameNetworkClient *client)
+	: NetworkServerSession(ioService)
+{
+	m_client = client;
+
+	// Keep the client thread running while no messages are queued
+	m_clientWork = new boost::asio::io_service::work(m_clientService);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LocalServerSession::~LocalServerSession()
+{
+	delete m_clientWork;
+
+	m_clientService.stop();
+	m_clientThread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::start()
+{
+	Logging::info("Started local session.");
+
+	m_clientThread = boost::thread(boost::bind(
+		static_cast<std::size_t (boost::asio::io_service::*)()>(
+			&boost::asio::io_service::run), &m_clientService));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::send(MessageDataPtr messageData)
+{
+	m_clientService.post(boost::bind(&LocalServerSession::deliver, this,
+		messageData));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::receive(MessageData messageData)
+{
+	m_ioService.post(boost::bind(&LocalServerSession::handleReceive, this,
+		messageData));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::close()
+{
+	{
+		boost::lock_guard<boost::mutex> lock(m_clientMutex);
+		m_client = NULL;
+	}
+
+	m_ioService.post(boost::bind(&LocalServerSession::handleClose, this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::deliver(MessageDataPtr messageData)
+{
+	boost::lock_guard<boost::mutex> lock(m_clientMutex);
+
+	if (m_client)
+		m_client->handleLocalMessage(*messageData);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::handleReceive(MessageData messageData)
+{
+	onMessageReceived(messageData);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::handleClose()
+{
+	Logging::info("Closed local session.");
+
+	notifyClosed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LocalServerSession::disconnect()
+{
+	Logging::warning("Local sessions cannot be disconnected by the server.");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LocalServerSession::reset()
+{
+	return false;
+}
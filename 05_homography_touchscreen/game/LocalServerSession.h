@@ -0,0 +1,104 @@
+#ifndef __GAME_LOCALSERVERSESSION_H
+#define __GAME_LOCALSERVERSESSION_H
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include "NetworkServerSession.h"
+#include "ForwardDeclarations.h"
+
+/**
+ * @class LocalServerSession
+ *
+ * @brief A server session with a client in the same process.
+ *
+ * Links a game network client directly to the server without a socket.
+ * Messages from the client are posted to the network server’s IO service, so
+ * the server handles them in its thread just like messages received via TCP.
+ * Messages to the client are queued and handled in a thread of the session,
+ * so neither side ever runs the other side’s handlers.
+ */
+class LocalServerSession : public NetworkServerSession
+{
+	public:
+		/**
+		 * @brief Creates a local session.
+		 *
+		 * @param ioService - The IO service of the network server.
+		 * @param client - The client to deliver the server’s messages to.
+		 */
+		LocalServerSession(boost::asio::io_service &ioService,
+			GameNetworkClient *client);
+		~LocalServerSession();
+
+		/**
+		 * @brief Starts the session.
+		 *
+		 * Starts the thread delivering messages to the client.
+		 */
+		void start();
+
+		using NetworkServerSession::send;
+
+		/**
+		 * @brief Sends a message to the client.
+		 *
+		 * Queues the message for the client without blocking the server.
+		 *
+		 * @param messageData - The data to send to the client.
+		 */
+		void send(MessageDataPtr messageData);
+
+		/**
+		 * @brief Passes a message of the client to the server.
+		 *
+		 * Called by the client. The server receives the message in its thread.
+		 *
+		 * @param messageData - The data to send to the server.
+		 */
+		void receive(MessageData messageData);
+
+		/**
+		 * @brief Closes the session.
+		 *
+		 * Called by the client. No messages are delivered to the client once
+		 * this returns, and the server is notified in its thread.
+		 */
+		void close();
+
+		/**
+		 * @brief Ignores disconnecting the client from the server side.
+		 *
+		 * The client in the same process owns the connection and closes it
+		 * itself.
+		 */
+		void disconnect();
+
+		/**
+		 * @brief Refuses to be reused.
+		 *
+		 * Local sessions run their own thread and are deleted when closed.
+		 *
+		 * @return false
+		 */
+		bool reset();
+
+	protected:
+		void deliver(MessageDataPtr messageData);
+
+		void handleReceive(MessageData messageData);
+		void handleClose();
+
+		/** @brief The queue of messages to the client and its thread. */
+		boost::asio::io_service m_clientService;
+		boost::asio::io_service::work *m_clientWork;
+		boost::thread m_clientThread;
+
+		/** @brief The connected client or NULL once closed. */
+		GameNetworkClient *m_client;
+
+		/** @brief Mutex keeping the client from closing during delivery. */
+		boost::mutex m_clientMutex;
+};
+
+#endif
@@ -1,7 +1,13 @@
 #include "Logging.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
+#include <boost/bind.hpp>
+
+#include "Atomic.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // Logging
@@ -22,36 +28,237 @@ Logging *Logging::instance()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+Logging::Logging()
+{
+	// Cell i is free for being written at position i
+	for (long i = 0; i < QUEUE_SIZE; i++)
+		m_cells[i].sequence = i;
+
+	m_enqueuePosition = 0;
+	m_dequeuePosition = 0;
+	m_droppedMessages = 0;
+
+	m_lastLevel = -1;
+	m_repeats = 0;
+
+	m_writerThread = boost::thread(boost::bind(&Logging::writeMessages, this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Logging::log(std::string text, int level)
 {
-	boost::lock_guard<boost::mutex> lock(m_loggingMutex);
+	if (!enqueue(level, text))
+		Atomic::increment(&m_droppedMessages);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Logging::enqueue(int level, const std::string &text)
+{
+	long position = Atomic::load(&m_enqueuePosition);
+	Cell *cell;
+
+	// Claim a position whose cell has been read already
+	while (true)
+	{
+		cell = &m_cells[position & (QUEUE_SIZE - 1)];
+		long difference = (long)((unsigned long)Atomic::load(&cell->sequence)
+			- (unsigned long)position);
+
+		if (difference == 0)
+		{
+			if (Atomic::compareAndSwap(&m_enqueuePosition, position,
+				position + 1))
+				break;
+		}
+		else if (difference < 0)
+			return false;
+
+		position = Atomic::load(&m_enqueuePosition);
+	}
+
+	cell->entry.level = level;
+	copyText(text, cell->entry.text);
+
+	// Hand the cell over to the writer thread
+	Atomic::store(&cell->sequence, position + 1);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Logging::copyText(const std::string &text, char *buffer)
+{
+	std::size_t length = 0;
+	std::size_t begin = 0;
+
+	do
+	{
+		std::size_t end = text.find('\n', begin);
+
+		if (end == std::string::npos)
+			end = text.length();
+
+		if (begin > 0)
+			buffer[length++] = '\n';
+
+		std::size_t lineLength = std::min(end - begin,
+			(std::size_t)MAX_LINE_LENGTH - 1);
+		lineLength = std::min(lineLength, MAX_TEXT_LENGTH - 1 - length);
+
+		memcpy(buffer + length, text.c_str() + begin, lineLength);
+		length += lineLength;
+
+		begin = end + 1;
+	}
+	while (begin < text.length() && length < MAX_TEXT_LENGTH - 1);
+
+	buffer[length] = '\0';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Logging::dequeue(Entry &entry)
+{
+	long position = m_dequeuePosition;
+	Cell &cell = m_cells[position & (QUEUE_SIZE - 1)];
+
+	if (Atomic::load(&cell.sequence) != position + 1)
+		return false;
+
+	entry = cell.entry;
+
+	// Free the cell for the position one round later
+	Atomic::store(&cell.sequence, position + QUEUE_SIZE);
+	Atomic::store(&m_dequeuePosition, position + 1);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Logging::writeMessages()
+{
+	Entry entry;
+
+	while (true)
+	{
+		bool hasWritten = false;
+
+		while (dequeue(entry))
+		{
+			write(entry.level, entry.text);
+			hasWritten = true;
+		}
+
+		long droppedMessages = Atomic::exchange(&m_droppedMessages, 0);
+
+		if (droppedMessages > 0)
+		{
+			reportRepeats();
+
+			std::cout << "[Warning] " << droppedMessages
+				<< " log messages dropped.\n";
+			hasWritten = true;
+		}
+
+		// Summarize repetitions once they have stopped for a while
+		if (m_repeats > 0 && boost::chrono::steady_clock::now()
+			- m_lastWriteTime >= boost::chrono::seconds(1))
+		{
+			reportRepeats();
+			hasWritten = true;
+		}
+
+		if (hasWritten)
+		{
+			std::cout.flush();
+			std::cerr.flush();
+		}
+		else
+			boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Logging::write(int level, const std::string &text)
+{
+	boost::chrono::steady_clock::time_point now
+		= boost::chrono::steady_clock::now();
+
+	// Write a repeated message at most once per second, comparing all of its
+	// lines
+	if (level == m_lastLevel && text == m_lastText
+		&& now - m_lastWriteTime < boost::chrono::seconds(1))
+	{
+		m_repeats++;
+		return;
+	}
+
+	reportRepeats();
+
+	m_lastLevel = level;
+	m_lastText = text;
+	m_lastWriteTime = now;
 
 	switch (level)
 	{
 		case Level::LEVEL_ERROR:
-			std::cerr << "[Error] " << text << std::endl;
+			std::cerr << "[Error] " << text << "\n";
 			break;
 
 		case Level::LEVEL_WARNING:
-			std::cout << "[Warning] " << text << std::endl;
+			std::cout << "[Warning] " << text << "\n";
 			break;
 
 		case Level::LEVEL_INFO:
-			std::cout << "[Info] " << text << std::endl;
+			std::cout << "[Info] " << text << "\n";
 			break;
 
 		case Level::LEVEL_DEBUG:
-			std::cout << "[Debug] " << text << std::endl;
+			std::cout << "[Debug] " << text << "\n";
 			break;
 
 		default:
-			std::cout << text << std::endl;
+			std::cout << text << "\n";
 			break;
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Logging::reportRepeats()
+{
+	if (m_repeats == 0)
+		return;
+
+	(m_lastLevel == Level::LEVEL_ERROR ? std::cerr : std::cout)
+		<< "[Info] Last message repeated " << m_repeats << " times.\n";
+
+	m_repeats = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Logging::flush()
+{
+	for (int i = 0; i < 1000; i++)
+	{
+		if (Atomic::load(&m_dequeuePosition) == Atomic::load(&m_enqueuePosition))
+			break;
+
+		boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+	}
+
+	// Let the writer thread finish writing the last entry
+	boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Logging::error(std::string text)
 {
 	instance()->log(text, Level::LEVEL_ERROR);
@@ -3,7 +3,8 @@
 
 #include <string>
 
-#include <boost/thread/mutex.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread.hpp>
 
 /**
  * @class Logging
@@ -13,6 +14,11 @@
  * This class serves for logging messages such as debug information, general
  * information, warnings and errors. The messages can be displayed on the
  * terminal or in a special GUI widget if a game client is running.
+ *
+ * Logging never blocks the calling thread. Messages are put into a bounded
+ * lock-free queue and written to the terminal by a background thread. If the
+ * queue is full, messages are dropped and counted. Identical messages logged
+ * in quick succession are summarized.
  */
 class Logging
 {
@@ -47,13 +53,22 @@ class Logging
 		/**
 		 * @brief Logs a message.
 		 *
-		 * Logs a message text with a specified level of importance.
+		 * Logs a message text with a specified level of importance. Each line
+		 * of the text is truncated to 255 characters and the whole text to
+		 * 1023 characters.
 		 *
 		 * @param text - The text to be logged.
 		 * @param level - The level of importance of the message.
 		 */
 		void log(std::string text, int level);
 
+		/**
+		 * @brief Waits until all messages have been written.
+		 *
+		 * Gives up after one second if other threads keep logging.
+		 */
+		void flush();
+
 		/**
 		 * @brief Logs an error.
 		 *
@@ -91,8 +106,76 @@ class Logging
 		static void debug(std::string text);
 
 	protected:
-		/** @brief Mutex providing thread-safe logging. */
-		boost::mutex m_loggingMutex;
+		Logging();
+
+		/** @brief Number of messages the queue can hold. */
+		enum {QUEUE_SIZE = 1024};
+
+		/** @brief Maximal length of a line including the terminating 0. */
+		enum {MAX_LINE_LENGTH = 256};
+
+		/** @brief Maximal length of a message including the terminating 0. */
+		enum {MAX_TEXT_LENGTH = 1024};
+
+		/**
+		 * @brief A message waiting to be written.
+		 *
+		 * Messages spanning multiple lines occupy a single entry, so that
+		 * their lines are never interleaved with those of other threads.
+		 */
+		struct Entry
+		{
+			int level;
+			char text[MAX_TEXT_LENGTH];
+		};
+
+		/**
+		 * @brief Slot of the queue.
+		 *
+		 * The sequence number tells whether the slot is free to be written
+		 * for a given position or holds an entry to be read.
+		 */
+		struct Cell
+		{
+			volatile long sequence;
+			Entry entry;
+		};
+
+		bool enqueue(int level, const std::string &text);
+		bool dequeue(Entry &entry);
+
+		/** @brief Copies a text, truncating its lines and itself. */
+		static void copyText(const std::string &text, char *buffer);
+
+		/** @brief Loop of the background thread writing the messages. */
+		void writeMessages();
+
+		void write(int level, const std::string &text);
+		void reportRepeats();
+
+		/** @brief The queue of entries, a bounded multi-producer ring. */
+		Cell m_cells[QUEUE_SIZE];
+
+		/** @brief The next position to write an entry to. */
+		volatile long m_enqueuePosition;
+
+		/** @brief The next position to read an entry from. */
+		volatile long m_dequeuePosition;
+
+		/** @brief Messages dropped because the queue was full. */
+		volatile long m_droppedMessages;
+
+		/** @brief The last message written, to detect repetitions. */
+		std::string m_lastText;
+		int m_lastLevel;
+
+		/** @brief The time the last message was written. */
+		boost::chrono::steady_clock::time_point m_lastWriteTime;
+
+		/** @brief Repetitions of the last message that were not written. */
+		int m_repeats;
+
+		boost::thread m_writerThread;
 };
 
 #endif
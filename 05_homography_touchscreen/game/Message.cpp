@@ -46,23 +46,8 @@ void Message::updateData(MessageData messageData)
 {
 	try
 	{
-		boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
-
-		// Look for a registered message type which matches the incoming message
-		// type
-		for (RegisteredMessageTypes::iterator i = m_registeredMessageTypes.begin();
-			i != m_registeredMessageTypes.end(); i++)
-		{
-			RegisteredMessageType test = *i;
-
-			if ((*i).header.contentType == messageData.contentType())
-			{
-				messageData.copyTo((*i).data);
-				break;
-			}
-		}
-
-		onUpdate();
+		if (decode(messageData))
+			onUpdate();
 	}
 	catch (std::exception &e)
 	{
@@ -74,14 +59,6 @@ void Message::updateData(MessageData messageData)
 
 void Message::synchronize(PlayerID receiverID, UpdateFrequency leastFrequency)
 {
-	boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
-
-	if (m_registeredMessageTypes.empty())
-	{
-		Logging::error("Message data has not been initialized.");
-		return;
-	}
-
 	if (!m_gameNetworkInterface)
 	{
 		Logging::error((std::string)"No network interface has been specified to "
@@ -89,25 +66,13 @@ void Message::synchronize(PlayerID receiverID, UpdateFrequency leastFrequency)
 		return;
 	}
 
-	// Look for all synchronizable message types which have been registered and
-	// send them if their update frequency is high enough
-	for (RegisteredMessageTypes::iterator i = m_registeredMessageTypes.begin();
-		i != m_registeredMessageTypes.end(); i++)
-	{
-		// Don't synchronize message types with a frequency lower than requested
-		if ((*i).updateFrequency < leastFrequency)
-			continue;
-
-		// Don't synchronize message types if sending is disabled
-		if (!(*i).isSendingEnabled)
-			continue;
-
-		// Prepare the data to be sent
-		MessageData messageData;
-		messageData.setHeader((*i).header);
-		messageData.copyContentFrom((*i).data);
-		m_gameNetworkInterface->send(messageData, receiverID);
-	}
+	// Don't synchronize messages with a frequency lower than requested
+	if (updateFrequency() < leastFrequency)
+		return;
+
+	MessageData messageData;
+	encode(messageData);
+	m_gameNetworkInterface->send(messageData, receiverID);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -126,90 +91,19 @@ void Message::synchronize(PlayerIDs receiverIDs, UpdateFrequency leastFrequency)
 void Message::synchronize(NetworkServerSession *session,
 	UpdateFrequency leastFrequency)
 {
-	boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
-
-	if (m_registeredMessageTypes.empty())
-	{
-		Logging::error("Message data has not been initialized.");
-		return;
-	}
-
 	if (!session)
 	{
 		Logging::error("Invalid network server session.");
 		return;
 	}
 
-	// Look for all synchronizable message types which have been registered and
-	// send them if their update frequency is high enough
-	for (RegisteredMessageTypes::iterator i = m_registeredMessageTypes.begin();
-		i != m_registeredMessageTypes.end(); i++)
-	{
-		// Don't synchronize message types with a frequency lower than requested
-		if ((*i).updateFrequency < leastFrequency)
-			continue;
-
-		// Don't synchronize message types if sending is disabled
-		if (!(*i).isSendingEnabled)
-			continue;
-
-		// Prepare the data to be sent
-		MessageData messageData;
-		messageData.setHeader((*i).header);
-		messageData.copyContentFrom((*i).data);
-		session->send(messageData);
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void Message::registerMessageType(ContentType contentType,
-	void *data, ContentLength contentLength, UpdateFrequency updateFrequency)
-{
-	// Create a message header for this message type
-	MessageHeader newMessageHeader;
-	newMessageHeader.contentType = contentType;
-	newMessageHeader.contentLength = contentLength;
-	newMessageHeader.messageID = m_messageID;
-
-	// Store the message header, data and update frequency together
-	RegisteredMessageType newRegisteredMessageType;
-	newRegisteredMessageType.isSendingEnabled = true;
-	newRegisteredMessageType.header = newMessageHeader;
-	newRegisteredMessageType.data = data;
-	newRegisteredMessageType.updateFrequency = updateFrequency;
-
-	boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
-
-	m_registeredMessageTypes.push_back(newRegisteredMessageType);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void Message::enableSendingMessageType(ContentType contentType)
-{
-	boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
-
-	for (RegisteredMessageTypes::iterator i = m_registeredMessageTypes.begin();
-		i != m_registeredMessageTypes.end(); i++)
-	{
-		if ((*i).header.contentType == contentType)
-			(*i).isSendingEnabled = true;
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void Message::disableSendingMessageType(ContentType contentType)
-{
-	boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
+	// Don't synchronize messages with a frequency lower than requested
+	if (updateFrequency() < leastFrequency)
+		return;
 
-	for (RegisteredMessageTypes::iterator i = m_registeredMessageTypes.begin();
-		i != m_registeredMessageTypes.end(); i++)
-	{
-		if ((*i).header.contentType == contentType)
-			(*i).isSendingEnabled = false;
-	}
+	MessageData messageData;
+	encode(messageData);
+	session->send(messageData);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -229,19 +123,11 @@ void Message::setMessageID(MessageID messageID)
 	if (m_gameNetworkInterface && messageID >= MESSAGE_ID_FIRST)
 		m_gameNetworkInterface->addMessageHandler(MESSAGE_ALL_TYPES,
 			messageID, boost::bind(&Message::updateData, this, _1));
-
-	boost::lock_guard<boost::mutex> lock(m_registeredMessageTypesMutex);
-
-	for (RegisteredMessageTypes::iterator i = m_registeredMessageTypes.begin();
-		i != m_registeredMessageTypes.end(); i++)
-	{
-		(*i).header.messageID = messageID;
-	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-MessageID Message::messageID()
+MessageID Message::messageID() const
 {
 	return m_messageID;
 }
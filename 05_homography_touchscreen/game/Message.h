@@ -3,7 +3,6 @@
 
 #include <boost/asio.hpp>
 #include <boost/signal.hpp>
-#include <boost/thread/mutex.hpp>
 
 #include "GameNetworkInterface.h"
 #include "MessageData.h"
@@ -29,9 +28,9 @@ typedef std::vector<PlayerID> PlayerIDs;
  *
  * @brief A message that can be synchronized via network.
  *
- * Messages can be synchronized via a TCP network connection. Therefore,
- * different members can be registered for network usage. For each member one
- * can define the frequency with which the message is synchronized.
+ * Messages can be synchronized via a TCP network connection. Subclasses define
+ * the type, the data and the update frequency of the message, usually at
+ * compile time by deriving from MessageSchema.
  */
 class Message
 {
@@ -63,7 +62,7 @@ class Message
 		 *
 		 * @return The message’s ID.
 		 */
-		MessageID messageID();
+		MessageID messageID() const;
 
 		/**
 		 * @brief Updates the network data of the message.
@@ -138,66 +137,33 @@ class Message
 
 	protected:
 		/**
-		 * @struct RegisteredMessageType
+		 * @brief Returns the type of the message’s data.
 		 *
-		 * @brief Information about how a message type has been registered.
-		 *
-		 * Specifies how a message type has been registered, i. e. which type it
-		 * has, where the data to synchronize resides, and with which frequency
-		 * the message will be sent via the network connection.
+		 * @return The content type sent with the message.
 		 */
-		struct RegisteredMessageType
-		{
-			/** @brief Whether sending the data of this type is enabled.*/
-			bool isSendingEnabled;
-
-			/** @brief The header matching this type of message data.*/
-			MessageHeader header;
-
-			/** @brief Pointer to the data which will be synchronized.*/
-			void *data;
-
-			/** @brief The frequency with which the data will be sent.*/
-			UpdateFrequency updateFrequency;
-		};
-
-		typedef std::vector<RegisteredMessageType> RegisteredMessageTypes;
+		virtual ContentType contentType() const = 0;
 
 		/**
-		 * @brief Prepares message data for being synchronized via network.
+		 * @brief Returns how often the message is synchronized.
 		 *
-		 * Specifies a member variable, its type and size to be able to
-		 * synchronize it on request via network.
-		 *
-		 * @param contentType - The data type of the message data.
-		 * @param data - Pointer to the data which will be synchronized.
-		 * @param contentLength - The size of the data to synchronize.
-		 * @param updateFrequency - The frequency with which the message data
-		 *     will be transmitted via network.
+		 * @return The update frequency of the message’s data.
 		 */
-		void registerMessageType(ContentType contentType,
-			void *data, ContentLength contentLength,
-			UpdateFrequency updateFrequency);
+		virtual UpdateFrequency updateFrequency() const = 0;
 
 		/**
-		 * @brief Enables sending message data of a given type.
-		 *
-		 * Enables sending message data of a given type. It will be synchronized
-		 * with the whole message.
+		 * @brief Writes the message into a network package.
 		 *
-		 * @param contentType - The data type of the message data.
+		 * @param messageData - (out) The package to write header and data to.
 		 */
-		void enableSendingMessageType(ContentType contentType);
+		virtual void encode(MessageData &messageData) const = 0;
 
 		/**
-		 * @brief Disables sending message data of a given type.
-		 *
-		 * Disables sending message data of a given type. It will be synchronized
-		 * with the whole message.
+		 * @brief Reads the message from a network package.
 		 *
-		 * @param contentType - The data type of the message data.
+		 * @param messageData - The package received via network.
+		 * @return Whether the package matched the message’s type and size.
 		 */
-		void disableSendingMessageType(ContentType contentType);
+		virtual bool decode(MessageData &messageData) = 0;
 
 		/**
 		 * @brief Sets the message ID directly.
@@ -212,12 +178,6 @@ class Message
 		GameNetworkInterface *m_gameNetworkInterface;
 
 	private:
-		/** @brief List of all message types that have been registered. */
-		RegisteredMessageTypes m_registeredMessageTypes;
-
-		/** @brief Mutex ensuring thread-safe message registration. */
-		boost::mutex m_registeredMessageTypesMutex;
-
 		/** @brief The message’s ID. */
 		MessageID m_messageID;
 
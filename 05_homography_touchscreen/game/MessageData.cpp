@@ -22,7 +22,7 @@ void MessageData::setMessageID(MessageID messageID)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-MessageID MessageData::messageID()
+MessageID MessageData::messageID() const
 {
 	return m_header.messageID;
 }
@@ -36,7 +36,7 @@ void MessageData::setContentType(ContentType contentType)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ContentType MessageData::contentType()
+ContentType MessageData::contentType() const
 {
 	return m_header.contentType;
 }
@@ -103,14 +103,14 @@ void MessageData::setContentLength(ContentLength contentLength)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ContentLength MessageData::contentLength()
+ContentLength MessageData::contentLength() const
 {
 	return m_header.contentLength;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ContentLength MessageData::headerLength()
+ContentLength MessageData::headerLength() const
 {
 	return sizeof(MessageHeader);
 }
@@ -5,11 +5,14 @@
 
 typedef unsigned __int8 uint8_t;
 typedef unsigned __int16 uint16_t;
+typedef unsigned __int32 uint32_t;
 
 #else
 #include <inttypes.h>
 #endif
 
+#include <boost/shared_ptr.hpp>
+
 #include <cstring>
 #include <iostream>
 #include <limits.h>
@@ -80,7 +83,7 @@ class MessageData
 		 *
 		 * @return The message ID of the network package.
 		 */
-		MessageID messageID();
+		MessageID messageID() const;
 
 		/**
 		 * @brief Sets the message type.
@@ -98,7 +101,7 @@ class MessageData
 		 *
 		 * @return The message type of the network package.
 		 */
-		ContentType contentType();
+		ContentType contentType() const;
 
 		/**
 		 * @brief Sets the message header.
@@ -178,7 +181,7 @@ class MessageData
 		 *
 		 * @return The length of the message content.
 		 */
-		ContentLength contentLength();
+		ContentLength contentLength() const;
 
 		/**
 		 * @brief Returns the message’s header length.
@@ -187,7 +190,7 @@ class MessageData
 		 *
 		 * @return The length of the message header.
 		 */
-		ContentLength headerLength();
+		ContentLength headerLength() const;
 
 		/**
 		 * @brief Copies the raw data.
@@ -229,4 +232,7 @@ class MessageData
 		NetworkServerSession *m_networkServerSession;
 };
 
+/** @brief Message data shared between several sessions, never modified. */
+typedef boost::shared_ptr<const MessageData> MessageDataPtr;
+
 #endif
@@ -0,0 +1,78 @@
+#ifndef __NETWORK_MESSAGESCHEMA_H
+#define __NETWORK_MESSAGESCHEMA_H
+
+#include <boost/static_assert.hpp>
+
+#include "Message.h"
+#include "MessageData.h"
+
+/**
+ * @class MessageSchema
+ *
+ * @brief A message whose type, data and update frequency are fixed.
+ *
+ * The content type, the layout of the data and the update frequency are
+ * compile-time constants, so encoding and decoding are a plain copy of the
+ * data without any lookup or locking. Subclasses access the data via m_data.
+ *
+ * @tparam CONTENT_TYPE - The type identifying the message’s data.
+ * @tparam Data - The plain struct synchronized via network.
+ * @tparam UPDATE_FREQUENCY - The frequency with which the data is sent.
+ */
+template <ContentType CONTENT_TYPE, class Data,
+	UpdateFrequency UPDATE_FREQUENCY>
+class MessageSchema : public Message
+{
+	BOOST_STATIC_ASSERT(sizeof(Data) <= MAX_MESSAGE_LENGTH);
+
+	public:
+		/**
+		 * @brief Creates a new message.
+		 *
+		 * @param gameNetworkInterface - The network interface to synchronize
+		 *     the message with.
+		 */
+		MessageSchema(GameNetworkInterface *gameNetworkInterface)
+			: Message(gameNetworkInterface)
+		{
+		}
+
+	protected:
+		ContentType contentType() const
+		{
+			return CONTENT_TYPE;
+		}
+
+		UpdateFrequency updateFrequency() const
+		{
+			return UPDATE_FREQUENCY;
+		}
+
+		void encode(MessageData &messageData) const
+		{
+			MessageHeader header;
+			header.messageID = messageID();
+			header.contentType = CONTENT_TYPE;
+			header.contentLength = sizeof(Data);
+
+			messageData.setHeader(header);
+			messageData.copyContentFrom((void*)&m_data, sizeof(Data));
+		}
+
+		bool decode(MessageData &messageData)
+		{
+			// Ignore data of other types and malformed packages
+			if (messageData.contentType() != CONTENT_TYPE
+				|| messageData.contentLength() != sizeof(Data))
+				return false;
+
+			messageData.copyTo(&m_data);
+
+			return true;
+		}
+
+		/** @brief The data to synchronize via network. */
+		Data m_data;
+};
+
+#endif
@@ -14,7 +14,10 @@ enum
 	MESSAGE_HIGHLIGHT_REQUEST,
 	MESSAGE_GAME_OBSTACLE,
 
-	MESSAGE_NEW_PLAYER_ID
+	MESSAGE_NEW_PLAYER_ID,
+
+	MESSAGE_CLOCK_SYNC,
+	MESSAGE_SELECTION_REQUEST
 };
 
 #endif
@@ -11,14 +11,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 MoveRequest::MoveRequest(GameNetworkInterface *gameNetworkInterface)
-	: Message(gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
 {
-	m_networkData.angle = 0;
-	m_networkData.strength = 0;
-
-	// Set up for network transmission via messages
-	registerMessageType(MESSAGE_MOVE_REQUEST, &m_networkData,
-		sizeof(NetworkData), UPDATE_FREQUENCY_ONCE);
+	m_data.angle = 0;
+	m_data.strength = 0;
+	m_data.traceID = 0;
+	m_data.inputSequence = 0;
 
 	setMessageID(MESSAGE_ID_EVENT);
 }
@@ -27,40 +25,68 @@ MoveRequest::MoveRequest(GameNetworkInterface *gameNetworkInterface)
 
 void MoveRequest::setUnitIndex(uint8_t unitIndex)
 {
-	m_networkData.unitIndex = unitIndex;
+	m_data.unitIndex = unitIndex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 uint8_t MoveRequest::unitIndex()
 {
-	return m_networkData.unitIndex;
+	return m_data.unitIndex;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void MoveRequest::setAngle(float angle)
 {
-	m_networkData.angle = angle;
+	m_data.angle = angle;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float MoveRequest::angle()
 {
-	return m_networkData.angle;
+	return m_data.angle;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void MoveRequest::setStrength(float strength)
 {
-	m_networkData.strength = strength;
+	m_data.strength = strength;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 float MoveRequest::strength()
 {
-	return m_networkData.strength;
+	return m_data.strength;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MoveRequest::setTraceID(uint32_t traceID)
+{
+	m_data.traceID = traceID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t MoveRequest::traceID()
+{
+	return m_data.traceID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MoveRequest::setInputSequence(uint32_t inputSequence)
+{
+	m_data.inputSequence = inputSequence;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t MoveRequest::inputSequence()
+{
+	return m_data.inputSequence;
 }
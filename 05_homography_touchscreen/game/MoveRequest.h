@@ -1,10 +1,22 @@
 #ifndef __GAME_MOVEREQUEST_H
 #define __GAME_MOVEREQUEST_H
 
-#include "Message.h"
+#include "MessageSchema.h"
+#include "MessageTypes.h"
 #include "ForwardDeclarations.h"
 
-class MoveRequest : public Message
+// Data to synchronize via network
+struct MoveRequestData
+{
+	uint8_t unitIndex;
+	float angle;
+	float strength;
+	uint32_t traceID;
+	uint32_t inputSequence;
+};
+
+class MoveRequest : public MessageSchema<MESSAGE_MOVE_REQUEST, MoveRequestData,
+	UPDATE_FREQUENCY_ONCE>
 {
 	public:
 		MoveRequest(GameNetworkInterface *gameNetworkInterface);
@@ -18,15 +30,14 @@ class MoveRequest : public Message
 		void setStrength(float strength);
 		float strength();
 
-	protected:
-		struct NetworkData
-		{
-			uint8_t unitIndex;
-			float angle;
-			float strength;
-		};
+		// Identifies the input for latency measurements, 0 if not traced
+		void setTraceID(uint32_t traceID);
+		uint32_t traceID();
 
-		NetworkData m_networkData;
+		// Numbers the move requests of a client, starting with 1, so that
+		// the client can tell which of them the server has applied
+		void setInputSequence(uint32_t inputSequence);
+		uint32_t inputSequence();
 };
 
 #endif
@@ -2,6 +2,8 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+
 #include "Logging.h"
 #include "NetworkServerSession.h"
 
@@ -14,6 +16,17 @@
 NetworkServer::NetworkServer()
 {
 	m_isRunning = false;
+
+	// Created right away, so that local sessions can be added before the
+	// server thread has started
+	m_ioService = new boost::asio::io_service;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServer::start()
+{
+	m_thread = boost::thread(boost::bind(&NetworkServer::run, this));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -46,6 +59,12 @@ void NetworkServer::run()
 void NetworkServer::stop()
 {
 	m_ioService->post(boost::bind(&NetworkServer::release, this));
+
+	// Handlers may refer to the owner of the server until the thread is done
+	m_thread.join();
+
+	delete m_ioService;
+	m_ioService = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -57,10 +76,69 @@ bool NetworkServer::isRunning()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+boost::asio::io_service &NetworkServer::ioService()
+{
+	return *m_ioService;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServer::addSession(NetworkServerSession *session)
+{
+	m_ioService->post(boost::bind(&NetworkServer::handleAddSession, this,
+		session));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServer::handleAddSession(NetworkServerSession *session)
+{
+	m_sessions.push_back(session);
+	session->start();
+
+	onSessionAccepted(session);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServer::removeSession(NetworkServerSession *session)
+{
+	m_ioService->post(boost::bind(&NetworkServer::handleRemoveSession, this,
+		session));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServer::handleRemoveSession(NetworkServerSession *session)
+{
+	std::vector<NetworkServerSession*>::iterator i
+		= std::find(m_sessions.begin(), m_sessions.end(), session);
+
+	if (i == m_sessions.end())
+		return;
+
+	m_sessions.erase(i);
+
+	// Reuse the session once no aborted operation can refer to it anymore
+	session->release(boost::bind(&NetworkServer::recycleSession, this,
+		session));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServer::recycleSession(NetworkServerSession *session)
+{
+	if (session->reset())
+		m_freeSessions.push_back(session);
+	else
+		delete session;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void NetworkServer::load()
 {
 	// Create a TCP connection point for clients on specified port
-	m_ioService = new boost::asio::io_service;
 	m_endpoint
 		= new boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 8642);
 	m_acceptor = new boost::asio::ip::tcp::acceptor(*m_ioService, *m_endpoint);
@@ -73,23 +151,40 @@ void NetworkServer::release()
 	m_isRunning = false;
 	m_ioService->stop();
 
-	delete m_ioService;
-	delete m_endpoint;
-	delete m_acceptor;
-
+	// Sessions own sockets of the IO service, so delete them first
 	for (std::vector<NetworkServerSession*>::iterator i = m_sessions.begin();
 		i != m_sessions.end(); i++)
 	{
 		delete *i;
 	}
+
+	for (std::vector<NetworkServerSession*>::iterator i
+		= m_freeSessions.begin(); i != m_freeSessions.end(); i++)
+	{
+		delete *i;
+	}
+
+	m_sessions.clear();
+	m_freeSessions.clear();
+
+	delete m_acceptor;
+	delete m_endpoint;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void NetworkServer::startAccept()
 {
-	// Create a new session
-	NetworkServerSession *new_session = new NetworkServerSession(*m_ioService);
+	// Reuse a closed session or create a new one
+	NetworkServerSession *new_session;
+
+	if (m_freeSessions.empty())
+		new_session = new NetworkServerSession(*m_ioService);
+	else
+	{
+		new_session = m_freeSessions.back();
+		m_freeSessions.pop_back();
+	}
 
 	// Wait for connection to establish
 	m_acceptor->async_accept(
@@ -112,9 +207,9 @@ void NetworkServer::handleAccept(NetworkServerSession *session,
 
 		onSessionAccepted(session);
 	}
-	// Else free the new session's memory
+	// Else keep the new session for the next connection
 	else
-		delete session;
+		m_freeSessions.push_back(session);
 
 	// Wait for next client to connect
 	startAccept();
@@ -3,6 +3,7 @@
 
 #include <boost/asio.hpp>
 #include <boost/signal.hpp>
+#include <boost/thread.hpp>
 
 #include <vector>
 
@@ -22,6 +23,14 @@ class NetworkServer
 	public:
 		NetworkServer();
 
+		/**
+		 * @brief Starts the network server thread.
+		 *
+		 * Runs the network server in a thread of its own, which is joined
+		 * when stopping the server.
+		 */
+		void start();
+
 		/**
 		 * @brief Runs the network server.
 		 *
@@ -34,7 +43,8 @@ class NetworkServer
 		 * @brief Stops the network server.
 		 *
 		 * Closes all sessions carefully, turns off the TCP endpoint and finally
-		 * ends up the network server thread.
+		 * ends up the network server thread. Returns once the thread has
+		 * finished, so no handler runs after this.
 		 */
 		void stop();
 
@@ -50,6 +60,38 @@ class NetworkServer
 		 */
 		bool isRunning();
 
+		/**
+		 * @brief Returns the IO service of the network server.
+		 *
+		 * The IO service exists from construction on, handlers posted to it
+		 * run in the network server’s thread once it is running.
+		 *
+		 * @return The boost::asio IO service.
+		 */
+		boost::asio::io_service &ioService();
+
+		/**
+		 * @brief Adds a session not accepted via TCP.
+		 *
+		 * Starts the session and announces it like an accepted one in the
+		 * network server’s thread. The server takes ownership of the session.
+		 *
+		 * @param session - The session to add.
+		 */
+		void addSession(NetworkServerSession *session);
+
+		/**
+		 * @brief Removes a closed session.
+		 *
+		 * Aborts the session’s pending operations in the network server’s
+		 * thread and reuses it for the next accepted connection once all of
+		 * them have been handled.
+		 * The session must not be used after calling this.
+		 *
+		 * @param session - The session to remove.
+		 */
+		void removeSession(NetworkServerSession *session);
+
 		/**
 		 * @brief Called when the network server accepts a new connection.
 		 *
@@ -91,9 +133,25 @@ class NetworkServer
 		void handleAccept(NetworkServerSession *session,
 			const boost::system::error_code &error);
 
+		void handleAddSession(NetworkServerSession *session);
+		void handleRemoveSession(NetworkServerSession *session);
+
+		/**
+		 * @brief Keeps a removed session for reuse.
+		 *
+		 * Called by the session once all of its aborted operations have been
+		 * handled. Deletes the session if it cannot be reused.
+		 *
+		 * @param session - The session to reuse.
+		 */
+		void recycleSession(NetworkServerSession *session);
+
 		/** @brief Network service. */
 		boost::asio::io_service *m_ioService;
 
+		/** @brief The thread running the network service. */
+		boost::thread m_thread;
+
 		/** @brief Network endpoint for connections. */
 		boost::asio::ip::tcp::endpoint *m_endpoint;
 
@@ -105,6 +163,9 @@ class NetworkServer
 
 		/** @brief All active sessions from clients. */
 		std::vector<NetworkServerSession*> m_sessions;
+
+		/** @brief Closed sessions ready to accept new clients. */
+		std::vector<NetworkServerSession*> m_freeSessions;
 };
 
 #endif
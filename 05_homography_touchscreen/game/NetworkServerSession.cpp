@@ -1,5 +1,6 @@
 #include "NetworkServerSession.h"
 
+#include "Atomic.h"
 #include "Logging.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -8,8 +9,29 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+const std::size_t NetworkServerSession::s_maxQueuedEvents = 1024;
+const std::size_t NetworkServerSession::s_maxQueuedEventBytes = 64 * 1024;
+const boost::chrono::seconds NetworkServerSession::s_maxWriteDuration(5);
+
+////////////////////////////////////////////////////////////////////////////////
+
 NetworkServerSession::NetworkServerSession(boost::asio::io_service &ioService)
-	: m_socket(ioService)
+	: m_ioService(ioService), m_socket(ioService)
+{
+	m_frontSequence = 0;
+	m_queuedBytes = 0;
+	m_queuedEvents = 0;
+	m_queuedEventBytes = 0;
+	m_replacedMessages = 0;
+	m_isSlow = false;
+	m_isDisconnecting = false;
+	m_isClosed = false;
+	m_pendingOperations = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+NetworkServerSession::~NetworkServerSession()
 {
 }
 
@@ -27,6 +49,15 @@ void NetworkServerSession::start()
 	Logging::info("Started network session.");
 
 	// Wait for first incoming message and read its header
+	readHeader();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::readHeader()
+{
+	beginOperation();
+
 	boost::asio::async_read(
 		m_socket,
 		boost::asio::buffer(&m_readBuffer, m_currentMessage.headerLength()),
@@ -43,7 +74,8 @@ void NetworkServerSession::handleReadHeader(const boost::system::error_code &err
 		Logging::warning((std::string)"Error occurred while reading message "
 			+ "header on server. Closing session with client.");
 
-		onClosed();
+		notifyClosed();
+		finishOperation();
 
 		return;
 	}
@@ -52,11 +84,15 @@ void NetworkServerSession::handleReadHeader(const boost::system::error_code &err
 	m_currentMessage.copyHeaderFrom(m_readBuffer);
 
 	// Wait for rest of the message and read its content
+	beginOperation();
+
 	boost::asio::async_read(
 		m_socket,
 		boost::asio::buffer(&m_readBuffer, m_currentMessage.contentLength()),
 		boost::bind(&NetworkServerSession::handleReadBody, this,
 			boost::asio::placeholders::error));
+
+	finishOperation();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -68,7 +104,8 @@ void NetworkServerSession::handleReadBody(const boost::system::error_code &error
 		Logging::warning((std::string)"Error occurred while reading message "
 			+ "body on server. Closing session with client.");
 
-		onClosed();
+		notifyClosed();
+		finishOperation();
 
 		return;
 	}
@@ -79,42 +116,160 @@ void NetworkServerSession::handleReadBody(const boost::system::error_code &error
 	onMessageReceived(m_currentMessage);
 
 	// Wait for next incoming message and read its header
-	boost::asio::async_read(
-		m_socket,
-		boost::asio::buffer(&m_readBuffer, m_currentMessage.headerLength()),
-		boost::bind(&NetworkServerSession::handleReadHeader, this,
-			boost::asio::placeholders::error));
+	readHeader();
+
+	finishOperation();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void NetworkServerSession::send(MessageData messageData)
+{
+	send(MessageDataPtr(new MessageData(messageData)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::send(MessageDataPtr messageData)
 {
 	deliver(messageData);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void NetworkServerSession::deliver(MessageData messageData)
+void NetworkServerSession::deliver(MessageDataPtr messageData)
 {
 	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
 
+	// Drop messages for clients which are being disconnected anyway
+	if (m_isDisconnecting)
+		return;
+
 	bool isWriteInProgress = !m_writeMessageQueue.empty();
 
+	if (isWriteInProgress && boost::chrono::steady_clock::now()
+		- m_writeStartTime > s_maxWriteDuration)
+	{
+		disconnectSlowClient("a write has not finished in time");
+		return;
+	}
+
+	// Send only the newest state of an entity
+	if (replaceQueuedMessage(messageData))
+		return;
+
+	std::size_t messageLength
+		= messageData->headerLength() + messageData->contentLength();
+
+	// Remember where the snapshot of the entity is queued
+	if (messageData->messageID() >= MESSAGE_ID_FIRST)
+	{
+		SnapshotKey key(messageData->messageID(), messageData->contentType());
+		m_queuedSnapshots[key]
+			= m_frontSequence + m_writeMessageQueue.size();
+	}
+	else
+	{
+		m_queuedEvents++;
+		m_queuedEventBytes += messageLength;
+	}
+
 	// Insert requested message into sending queue
 	m_writeMessageQueue.push_back(messageData);
+	m_queuedBytes += messageLength;
+
+	if (m_queuedEvents > s_maxQueuedEvents
+		|| m_queuedEventBytes > s_maxQueuedEventBytes)
+	{
+		disconnectSlowClient("its send queue is full");
+		return;
+	}
 
 	// Wait for the queue to be empty before sending
 	if (isWriteInProgress)
 		return;
 
+	writeFront();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool NetworkServerSession::replaceQueuedMessage(MessageDataPtr messageData)
+{
+	// Events have no entity whose state could be outdated
+	if (messageData->messageID() < MESSAGE_ID_FIRST)
+		return false;
+
+	QueuedSnapshots::const_iterator queuedSnapshot = m_queuedSnapshots.find(
+		SnapshotKey(messageData->messageID(), messageData->contentType()));
+
+	// The message being written has been handed to the socket already
+	if (queuedSnapshot == m_queuedSnapshots.end()
+		|| queuedSnapshot->second == m_frontSequence)
+		return false;
+
+	MessageDataPtr &queuedMessage
+		= m_writeMessageQueue[queuedSnapshot->second - m_frontSequence];
+
+	m_queuedBytes -= queuedMessage->contentLength();
+	m_queuedBytes += messageData->contentLength();
+
+	queuedMessage = messageData;
+	m_replacedMessages++;
+
+	// A snapshot still queued from the previous tick means the client lags
+	if (!m_isSlow)
+	{
+		m_isSlow = true;
+		Logging::warning("Client does not keep up with the messages sent.");
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::popFront()
+{
+	const MessageDataPtr &messageData = m_writeMessageQueue.front();
+	std::size_t messageLength
+		= messageData->headerLength() + messageData->contentLength();
+
+	if (messageData->messageID() >= MESSAGE_ID_FIRST)
+	{
+		QueuedSnapshots::iterator queuedSnapshot = m_queuedSnapshots.find(
+			SnapshotKey(messageData->messageID(), messageData->contentType()));
+
+		if (queuedSnapshot != m_queuedSnapshots.end()
+			&& queuedSnapshot->second == m_frontSequence)
+			m_queuedSnapshots.erase(queuedSnapshot);
+	}
+	else
+	{
+		m_queuedEvents--;
+		m_queuedEventBytes -= messageLength;
+	}
+
+	m_queuedBytes -= messageLength;
+	m_writeMessageQueue.pop_front();
+	m_frontSequence++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::writeFront()
+{
 	int dataLength = m_currentMessage.headerLength()
-		+ m_writeMessageQueue.front().contentLength();
+		+ m_writeMessageQueue.front()->contentLength();
+
+	m_writeStartTime = boost::chrono::steady_clock::now();
+
+	beginOperation();
 
 	// Write message via network eventually
 	boost::asio::async_write(
 		m_socket,
-		boost::asio::buffer(&m_writeMessageQueue.front(), dataLength),
+		boost::asio::buffer(m_writeMessageQueue.front().get(), dataLength),
 		boost::bind(&NetworkServerSession::handleWrite, this,
 			boost::asio::placeholders::error));
 }
@@ -128,26 +283,169 @@ void NetworkServerSession::handleWrite(const boost::system::error_code &error)
 		Logging::warning((std::string)"Error occurred while writing message "
 			+ "for client. Closing session with client.");
 
-		onClosed();
+		notifyClosed();
+		finishOperation();
 
 		return;
 	}
 
-	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+	{
+		boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+
+		// If last message has been sent, remove it from the queue's beginning
+		popFront();
+
+		// Send next messages if there are remaining ones in the queue
+		if (!m_writeMessageQueue.empty())
+			writeFront();
+		else if (m_isSlow)
+		{
+			m_isSlow = false;
+			Logging::info("Client has caught up with the messages sent.");
+		}
+	}
 
-	// If last message has been sent, remove it from the queue's beginning
-	m_writeMessageQueue.pop_front();
+	// Released sessions may be reused right away, so unlock the queue first
+	finishOperation();
+}
 
-	if (m_writeMessageQueue.empty())
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::disconnectSlowClient(const std::string &reason)
+{
+	Logging::warning("Disconnecting slow client, because " + reason + ".");
+
+	m_isDisconnecting = true;
+
+	disconnect();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::disconnect()
+{
+	m_ioService.post(
+		boost::bind(&NetworkServerSession::handleDisconnect, this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::handleDisconnect()
+{
+	// Pending reads and writes fail, which closes the session
+	boost::system::error_code error;
+	m_socket.close(error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::beginOperation()
+{
+	Atomic::increment(&m_pendingOperations);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::finishOperation()
+{
+	if (Atomic::decrement(&m_pendingOperations) > 0 || !m_releaseHandler)
 		return;
 
-	int dataLength = m_currentMessage.headerLength()
-		+ m_writeMessageQueue.front().contentLength();
+	boost::function<void ()> releaseHandler;
+	releaseHandler.swap(m_releaseHandler);
 
-	// Send next messages if there are remaining ones in the queue
-	boost::asio::async_write(
-		m_socket,
-		boost::asio::buffer(&m_writeMessageQueue.front(), dataLength),
-		boost::bind(&NetworkServerSession::handleWrite, this,
-			boost::asio::placeholders::error));
+	releaseHandler();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::release(const boost::function<void ()> &handler)
+{
+	{
+		boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+
+		// Start no more writes
+		m_isDisconnecting = true;
+	}
+
+	// Abort pending reads and writes. On some platforms their handlers run
+	// long after closing the socket, so wait for all of them.
+	boost::system::error_code error;
+	m_socket.close(error);
+
+	if (Atomic::load(&m_pendingOperations) > 0)
+	{
+		m_releaseHandler = handler;
+		return;
+	}
+
+	handler();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkServerSession::notifyClosed()
+{
+	if (m_isClosed)
+		return;
+
+	m_isClosed = true;
+
+	onClosed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool NetworkServerSession::reset()
+{
+	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+
+	m_writeMessageQueue.clear();
+	m_queuedSnapshots.clear();
+	m_frontSequence = 0;
+	m_queuedBytes = 0;
+	m_queuedEvents = 0;
+	m_queuedEventBytes = 0;
+	m_replacedMessages = 0;
+	m_isSlow = false;
+	m_isDisconnecting = false;
+	m_isClosed = false;
+	m_releaseHandler.clear();
+
+	onMessageReceived.disconnect_all_slots();
+	onClosed.disconnect_all_slots();
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t NetworkServerSession::queuedMessages() const
+{
+	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+	return m_writeMessageQueue.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t NetworkServerSession::queuedBytes() const
+{
+	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+	return m_queuedBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int NetworkServerSession::replacedMessages() const
+{
+	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+	return m_replacedMessages;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool NetworkServerSession::isSlow() const
+{
+	boost::lock_guard<boost::mutex> lock(m_writeMessageQueueMutex);
+	return m_isSlow;
 }
@@ -3,10 +3,13 @@
 
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
 #include <boost/signal.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include <deque>
+#include <map>
 
 #include "MessageData.h"
 
@@ -16,6 +19,12 @@
  * @brief A network server session.
  *
  * A network server session handles the connection to a connected client.
+ *
+ * A queued state snapshot of an entity is replaced by a newer one instead of
+ * being sent twice, so snapshots never exceed one per entity however many
+ * entities a level has. Only events accumulate and are thus limited in number
+ * and size. Clients which are a whole tick behind are flagged as slow and
+ * disconnected if their events overflow or a write does not finish in time.
  */
 class NetworkServerSession
 {
@@ -28,6 +37,7 @@ class NetworkServerSession
 		 * @param ioService - The boost::asio IO service.
 		 */
 		NetworkServerSession(boost::asio::io_service &ioService);
+		virtual ~NetworkServerSession();
 
 		/**
 		 * @brief Returns the TCP socket of the connected client.
@@ -43,7 +53,7 @@ class NetworkServerSession
 		 *
 		 * Starts reading from the network server session.
 		 */
-		void start();
+		virtual void start();
 
 		/**
 		 * @brief Sends a message to the client.
@@ -54,6 +64,77 @@ class NetworkServerSession
 		 */
 		void send(MessageData messageData);
 
+		/**
+		 * @brief Sends shared message data to the client.
+		 *
+		 * Queues only a reference to the data, so that the same data can be
+		 * sent to many clients without copying it.
+		 *
+		 * @param messageData - The data to send to the client.
+		 */
+		virtual void send(MessageDataPtr messageData);
+
+		/**
+		 * @brief Returns the number of messages waiting to be written.
+		 *
+		 * @return The number of queued messages including the one in progress.
+		 */
+		std::size_t queuedMessages() const;
+
+		/**
+		 * @brief Returns the number of bytes waiting to be written.
+		 *
+		 * @return The size of all queued messages as sent via network.
+		 */
+		std::size_t queuedBytes() const;
+
+		/**
+		 * @brief Returns the number of snapshots replaced by newer ones.
+		 *
+		 * @return The number of queued messages which have not been sent.
+		 */
+		unsigned int replacedMessages() const;
+
+		/**
+		 * @brief Whether the client does not keep up with the messages.
+		 *
+		 * A client is slow from when a queued snapshot has been replaced
+		 * until the queue has been written completely.
+		 *
+		 * @return Whether the client is slow.
+		 */
+		bool isSlow() const;
+
+		/**
+		 * @brief Disconnects the client.
+		 *
+		 * Closes the connection in the IO service’s thread. The session emits
+		 * onClosed once all pending operations have been aborted.
+		 */
+		virtual void disconnect();
+
+		/**
+		 * @brief Aborts all operations of a closed session.
+		 *
+		 * Closes the socket and calls the handler in the IO service’s thread
+		 * once the handlers of all aborted reads and writes have run, so that
+		 * none of them can see the session’s next client. Must be called in
+		 * the IO service’s thread.
+		 *
+		 * @param handler - Called when the session is no longer in use.
+		 */
+		void release(const boost::function<void ()> &handler);
+
+		/**
+		 * @brief Prepares a released session for reuse.
+		 *
+		 * Drops all queued messages and disconnects all slots, so that the
+		 * session can accept the next client.
+		 *
+		 * @return Whether the session can be reused.
+		 */
+		virtual bool reset();
+
 		/**
 		 * @brief Signal emitted whenever a message has been received.
 		 */
@@ -65,6 +146,32 @@ class NetworkServerSession
 		boost::signal<void ()> onClosed;
 
 	protected:
+		/**
+		 * @brief Emits onClosed unless the session has been closed already.
+		 *
+		 * Reading and writing may both fail when the connection is lost, but
+		 * the session is closed only once.
+		 */
+		void notifyClosed();
+
+		/**
+		 * @brief Starts reading the header of the next message.
+		 */
+		void readHeader();
+
+		/**
+		 * @brief Marks a read or write as started.
+		 */
+		void beginOperation();
+
+		/**
+		 * @brief Marks a read or write as handled.
+		 *
+		 * Called at the end of each handler. Calls the release handler once
+		 * the last operation of a released session has been handled.
+		 */
+		void finishOperation();
+
 		/**
 		 * @brief Callback handling incoming message headers.
 		 *
@@ -92,7 +199,41 @@ class NetworkServerSession
 		 *
 		 * @param messageData - The message data to send.
 		 */
-		void deliver(MessageData messageData);
+		void deliver(MessageDataPtr messageData);
+
+		/**
+		 * @brief Replaces a queued snapshot of the same entity.
+		 *
+		 * Messages with a regular message ID carry the state of an entity, so
+		 * only the newest one needs to be sent. The message currently being
+		 * written is never replaced. Queued snapshots are looked up by their
+		 * entity, so replacing does not depend on the length of the queue.
+		 *
+		 * @param messageData - The new message data.
+		 * @return Whether a queued message has been replaced.
+		 */
+		bool replaceQueuedMessage(MessageDataPtr messageData);
+
+		/**
+		 * @brief Removes the first message of the queue once it is written.
+		 */
+		void popFront();
+
+		/**
+		 * @brief Starts writing the first message of the queue.
+		 */
+		void writeFront();
+
+		/**
+		 * @brief Disconnects a client which does not keep up.
+		 *
+		 * Closes the socket in the IO service’s thread, which aborts all
+		 * pending operations and thereby closes the session.
+		 *
+		 * @param reason - Why the client is disconnected.
+		 */
+		void disconnectSlowClient(const std::string &reason);
+		void handleDisconnect();
 
 		/**
 		 * @brief Callback handling outgoing message bodies.
@@ -103,6 +244,9 @@ class NetworkServerSession
 		 */
 		void handleWrite(const boost::system::error_code &error);
 
+		/** @brief The IO service running the session’s handlers. */
+		boost::asio::io_service &m_ioService;
+
 		/** @brief The socket to send and receive messages with. */
 		boost::asio::ip::tcp::socket m_socket;
 
@@ -112,11 +256,62 @@ class NetworkServerSession
 		/** @brief Holds the aggregated incoming data. */
 		MessageData m_currentMessage;
 
+		/** @brief Maximal number of events waiting to be written. */
+		static const std::size_t s_maxQueuedEvents;
+
+		/** @brief Maximal number of event bytes waiting to be written. */
+		static const std::size_t s_maxQueuedEventBytes;
+
+		/** @brief Maximal time a single write may take. */
+		static const boost::chrono::seconds s_maxWriteDuration;
+
 		/** @brief List of all messages that will be sent soon. */
-		std::deque<MessageData> m_writeMessageQueue;
+		std::deque<MessageDataPtr> m_writeMessageQueue;
+
+		/** @brief Identifies the entity a snapshot carries the state of. */
+		typedef std::pair<MessageID, ContentType> SnapshotKey;
+
+		/** @brief Maps entities to the sequence number of their snapshot. */
+		typedef std::map<SnapshotKey, uint64_t> QueuedSnapshots;
+
+		/** @brief The queued snapshots by entity. */
+		QueuedSnapshots m_queuedSnapshots;
+
+		/** @brief The sequence number of the first queued message. */
+		uint64_t m_frontSequence;
+
+		/** @brief The size of all queued messages in bytes. */
+		std::size_t m_queuedBytes;
+
+		/** @brief The number of queued events. */
+		std::size_t m_queuedEvents;
+
+		/** @brief The size of all queued events in bytes. */
+		std::size_t m_queuedEventBytes;
+
+		/** @brief The number of queued messages replaced by newer ones. */
+		unsigned int m_replacedMessages;
+
+		/** @brief When writing the first queued message has started. */
+		boost::chrono::steady_clock::time_point m_writeStartTime;
+
+		/** @brief Whether the client does not keep up. */
+		bool m_isSlow;
+
+		/** @brief Whether the client is being disconnected. */
+		bool m_isDisconnecting;
+
+		/** @brief Whether onClosed has been emitted. */
+		bool m_isClosed;
+
+		/** @brief The number of reads and writes not handled yet. */
+		volatile long m_pendingOperations;
+
+		/** @brief Called once a released session is no longer in use. */
+		boost::function<void ()> m_releaseHandler;
 
 		/** @brief Mutex ensuring thread-safety of message delivery. */
-		boost::mutex m_writeMessageQueueMutex;
+		mutable boost::mutex m_writeMessageQueueMutex;
 };
 
 #endif
@@ -11,13 +11,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 NewPlayerID::NewPlayerID(GameNetworkInterface *gameNetworkInterface)
-	: Message(gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
 {
-	m_networkData.playerID = ID_NONE;
-
-	// Set up for network transmission via messages
-	registerMessageType(MESSAGE_NEW_PLAYER_ID, &m_networkData,
-		sizeof(NetworkData), UPDATE_FREQUENCY_ONCE);
+	m_data.playerID = ID_NONE;
 
 	setMessageID(MESSAGE_ID_EVENT);
 }
@@ -26,12 +22,12 @@ NewPlayerID::NewPlayerID(GameNetworkInterface *gameNetworkInterface)
 
 void NewPlayerID::setPlayerID(PlayerID playerID)
 {
-	m_networkData.playerID = playerID;
+	m_data.playerID = playerID;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 PlayerID NewPlayerID::playerID()
 {
-	return m_networkData.playerID;
+	return m_data.playerID;
 }
@@ -1,24 +1,24 @@
 #ifndef __GAME_NEW_PLAYER_ID_H
 #define __GAME_NEW_PLAYER_ID_H
 
-#include "Message.h"
+#include "MessageSchema.h"
+#include "MessageTypes.h"
 #include "ForwardDeclarations.h"
 
-class NewPlayerID : public Message
+// Data to synchronize via network
+struct NewPlayerIDData
+{
+	PlayerID playerID;
+};
+
+class NewPlayerID : public MessageSchema<MESSAGE_NEW_PLAYER_ID, NewPlayerIDData,
+	UPDATE_FREQUENCY_ONCE>
 {
 	public:
 		NewPlayerID(GameNetworkInterface *gameNetworkInterface);
 
 		void setPlayerID(PlayerID playerID);
 		PlayerID playerID();
-
-	protected:
-		struct NetworkData
-		{
-			PlayerID playerID;
-		};
-
-		NetworkData m_networkData;
 };
 
 #endif
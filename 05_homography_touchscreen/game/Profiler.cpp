@@ -0,0 +1,234 @@
+#include "Profiler.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "Logging.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Profiler
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler *Profiler::s_instance = NULL;
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler *Profiler::instance()
+{
+	if (!s_instance)
+		s_instance = new Profiler;
+
+	return s_instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::Profiler()
+	: m_threadHistograms(&Profiler::keepThreadHistograms)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::keepThreadHistograms(ThreadHistograms *threadHistograms)
+{
+	// The histograms outlive their thread and are deleted by the profiler
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::StageID Profiler::stage(const std::string &name)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	std::map<std::string, StageID>::iterator stageID = m_stageIDs.find(name);
+
+	if (stageID != m_stageIDs.end())
+		return (*stageID).second;
+
+	if (m_stageNames.size() >= MAX_STAGES)
+	{
+		Logging::warning("Too many profiler stages, ignoring " + name + ".");
+		return -1;
+	}
+
+	StageID newStageID = m_stageNames.size();
+	m_stageNames.push_back(name);
+	m_stageIDs[name] = newStageID;
+
+	return newStageID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Profiler::ThreadHistograms *Profiler::threadHistograms()
+{
+	ThreadHistograms *threadHistograms = m_threadHistograms.get();
+
+	if (threadHistograms)
+		return threadHistograms;
+
+	// First duration recorded by this thread
+	threadHistograms = new ThreadHistograms;
+	memset(threadHistograms, 0, sizeof(ThreadHistograms));
+
+	m_threadHistograms.reset(threadHistograms);
+
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	m_allThreadHistograms.push_back(threadHistograms);
+
+	return threadHistograms;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::record(StageID stageID, boost::chrono::nanoseconds duration)
+{
+	if (stageID < 0 || stageID >= MAX_STAGES)
+		return;
+
+	boost::uint64_t nanoseconds = duration.count() > 0 ? duration.count() : 0;
+
+	Histogram &histogram = threadHistograms()->stages[stageID];
+	histogram.counts[bucket(nanoseconds)]++;
+
+	if (nanoseconds > histogram.maximum)
+		histogram.maximum = nanoseconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int Profiler::bucket(boost::uint64_t nanoseconds)
+{
+	// Small values are counted exactly
+	if (nanoseconds < SUB_BUCKETS)
+		return (int)nanoseconds;
+
+	int exponent = 0;
+
+	while ((nanoseconds >> exponent) >= 2 * SUB_BUCKETS)
+		exponent++;
+
+	// The SUB_BUCKETS values after the leading bit select the sub-bucket
+	int index = (exponent + 1) * SUB_BUCKETS
+		+ (int)(nanoseconds >> exponent) - SUB_BUCKETS;
+
+	return (index < BUCKETS) ? index : BUCKETS - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::uint64_t Profiler::bucketValue(int bucket)
+{
+	if (bucket < SUB_BUCKETS)
+		return bucket;
+
+	int exponent = bucket / SUB_BUCKETS - 1;
+
+	return (boost::uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << exponent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::dump()
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	std::stringstream report;
+	report << "Stage latencies in microseconds:" << std::endl
+		<< std::setw(28) << std::left << "stage" << std::right
+		<< std::setw(10) << "count" << std::setw(12) << "p50"
+		<< std::setw(12) << "p99" << std::setw(12) << "max";
+
+	report << std::fixed << std::setprecision(1);
+
+	for (unsigned int stageID = 0; stageID < m_stageNames.size(); stageID++)
+	{
+		std::vector<boost::uint64_t> counts(BUCKETS, 0);
+		boost::uint64_t count = 0;
+		boost::uint64_t maximum = 0;
+
+		for (unsigned int i = 0; i < m_allThreadHistograms.size(); i++)
+		{
+			const Histogram &histogram
+				= m_allThreadHistograms[i]->stages[stageID];
+
+			for (int j = 0; j < BUCKETS; j++)
+			{
+				counts[j] += histogram.counts[j];
+				count += histogram.counts[j];
+			}
+
+			if (histogram.maximum > maximum)
+				maximum = histogram.maximum;
+		}
+
+		if (count == 0)
+			continue;
+
+		// Find the buckets containing the median and the 99th percentile
+		boost::uint64_t median = 0;
+		boost::uint64_t percentile99 = 0;
+		boost::uint64_t seen = 0;
+
+		for (int j = 0; j < BUCKETS; j++)
+		{
+			if (counts[j] == 0)
+				continue;
+
+			if (seen < (count + 1) / 2 && seen + counts[j] >= (count + 1) / 2)
+				median = bucketValue(j);
+
+			if (seen < (count * 99 + 99) / 100
+				&& seen + counts[j] >= (count * 99 + 99) / 100)
+				percentile99 = bucketValue(j);
+
+			seen += counts[j];
+		}
+
+		report << std::endl << std::setw(28) << std::left
+			<< m_stageNames[stageID]
+			<< std::right << std::setw(10) << count
+			<< std::setw(12) << median / 1000.0
+			<< std::setw(12) << percentile99 / 1000.0
+			<< std::setw(12) << maximum / 1000.0;
+	}
+
+	Logging::info(report.str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// ScopedTimer
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ScopedTimer::ScopedTimer(Profiler::StageID stageID)
+{
+	m_stageID = stageID;
+	m_isRunning = true;
+	m_startTime = boost::chrono::steady_clock::now();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ScopedTimer::~ScopedTimer()
+{
+	stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ScopedTimer::stop()
+{
+	if (!m_isRunning)
+		return;
+
+	m_isRunning = false;
+
+	Profiler::instance()->record(m_stageID,
+		boost::chrono::steady_clock::now() - m_startTime);
+}
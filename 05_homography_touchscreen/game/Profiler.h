@@ -0,0 +1,171 @@
+#ifndef __GENERAL_PROFILER_H
+#define __GENERAL_PROFILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+/**
+ * @class Profiler
+ *
+ * @brief Collects latency histograms of named stages.
+ *
+ * Each thread records into its own set of histograms, so that recording a
+ * duration needs neither locks nor atomic operations. The histograms are only
+ * merged when they are dumped. Durations are sorted into log-linear buckets
+ * with a relative error of less than 1/16, covering one nanosecond up to more
+ * than a minute.
+ *
+ * Use the PROFILE_SCOPE macro to time a block:
+ *
+ * @code
+ * {
+ *     PROFILE_SCOPE("render");
+ *     ...
+ * }
+ * @endcode
+ */
+class Profiler : private boost::noncopyable
+{
+	public:
+		typedef int StageID;
+
+		/**
+		 * @brief Returns the profiler singleton.
+		 *
+		 * @return The singleton instance of the profiler.
+		 */
+		static Profiler *instance();
+
+		/**
+		 * @brief Registers a stage.
+		 *
+		 * Registering the same name again returns the same ID, so that
+		 * threads racing to register a stage agree on its ID.
+		 *
+		 * @param name - The name of the stage.
+		 *
+		 * @return The ID of the stage or -1 if there are too many stages.
+		 */
+		StageID stage(const std::string &name);
+
+		/**
+		 * @brief Records the duration of a stage.
+		 *
+		 * Adds the duration to the calling thread’s histogram of the stage.
+		 *
+		 * @param stageID - The stage as returned by stage().
+		 * @param duration - The time the stage took.
+		 */
+		void record(StageID stageID, boost::chrono::nanoseconds duration);
+
+		/**
+		 * @brief Logs the latencies of all stages.
+		 *
+		 * Merges the histograms of all threads and logs the number of
+		 * samples, the median, the 99th percentile and the maximum of each
+		 * stage. Values recorded concurrently may be missed.
+		 */
+		void dump();
+
+	protected:
+		Profiler();
+
+		/** @brief The singleton instance of the profiler. */
+		static Profiler *s_instance;
+
+		/** @brief Maximum number of stages. */
+		enum {MAX_STAGES = 64};
+
+		/** @brief Sub-buckets per power of two. */
+		enum {SUB_BUCKETS = 16};
+
+		/** @brief Buckets covering durations up to 2^40 ns. */
+		enum {BUCKETS = (40 - 3) * SUB_BUCKETS};
+
+		/** @brief Latency histogram of one stage in one thread. */
+		struct Histogram
+		{
+			boost::uint32_t counts[BUCKETS];
+			boost::uint64_t maximum;
+		};
+
+		/** @brief The histograms of all stages in one thread. */
+		struct ThreadHistograms
+		{
+			Histogram stages[MAX_STAGES];
+		};
+
+		ThreadHistograms *threadHistograms();
+
+		static int bucket(boost::uint64_t nanoseconds);
+		static boost::uint64_t bucketValue(int bucket);
+
+		static void keepThreadHistograms(ThreadHistograms *threadHistograms);
+
+		/** @brief The histograms of the calling thread. */
+		boost::thread_specific_ptr<ThreadHistograms> m_threadHistograms;
+
+		/**
+		 * @brief The histograms of all threads.
+		 *
+		 * Owned by the profiler, so that they can be dumped after their
+		 * threads have ended.
+		 */
+		std::vector<ThreadHistograms *> m_allThreadHistograms;
+
+		std::map<std::string, StageID> m_stageIDs;
+		std::vector<std::string> m_stageNames;
+
+		/** @brief Mutex protecting stage and thread registration. */
+		boost::mutex m_mutex;
+};
+
+/**
+ * @class ScopedTimer
+ *
+ * @brief Records the time until it is destroyed or stopped.
+ */
+class ScopedTimer : private boost::noncopyable
+{
+	public:
+		ScopedTimer(Profiler::StageID stageID);
+		~ScopedTimer();
+
+		/**
+		 * @brief Records the time elapsed so far.
+		 *
+		 * Nothing is recorded on destruction after the timer has been
+		 * stopped.
+		 */
+		void stop();
+
+	protected:
+		Profiler::StageID m_stageID;
+		boost::chrono::steady_clock::time_point m_startTime;
+		bool m_isRunning;
+};
+
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+
+/**
+ * @brief Times the rest of the enclosing block as the named stage.
+ *
+ * The stage is looked up once per call site. Static initialization isn't
+ * thread-safe with all compilers, which is fine because registration is
+ * idempotent.
+ */
+#define PROFILE_SCOPE(name) \
+	static const Profiler::StageID PROFILE_CONCATENATE(profileStage, __LINE__) \
+		= Profiler::instance()->stage(name); \
+	ScopedTimer PROFILE_CONCATENATE(scopedTimer, __LINE__)( \
+		PROFILE_CONCATENATE(profileStage, __LINE__))
+
+#endif
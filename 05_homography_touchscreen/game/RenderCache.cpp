@@ -0,0 +1,177 @@
+#include "RenderCache.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "GameObstacle.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// RenderCache
+//
+////////////////////////////////////////////////////////////////////////////////
+
+RenderCache::RenderCache()
+{
+	m_staticLayer = cv::Mat(480, 480, CV_8UC3);
+	m_renderedImageData = NULL;
+	m_isValid = false;
+
+	renderStaticLayer(GameObstacleStates());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RenderCache::invalidate()
+{
+	m_isValid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RenderCache::render(cv::Mat &image, const GameState &gameState)
+{
+	const GameUnitStates &units = gameState.units();
+
+	if (haveObstaclesChanged(gameState.obstacles()))
+	{
+		renderStaticLayer(gameState.obstacles());
+		m_isValid = false;
+	}
+
+	if (image.data != m_renderedImageData || image.size() != m_staticLayer.size())
+		m_isValid = false;
+
+	// Render everything from scratch if nothing can be reused
+	if (!m_isValid)
+	{
+		m_staticLayer.copyTo(image);
+
+		for (unsigned int i = 0; i < units.size(); i++)
+			m_unitSpriteAtlas.render(image, units[i]);
+
+		m_renderedUnits = units;
+		m_renderedImageData = image.data;
+		m_isValid = true;
+
+		return;
+	}
+
+	std::vector<cv::Rect> dirtyRegions;
+	std::vector<bool> isDirty(units.size(), false);
+
+	// Regions of units that have been moved, changed or removed
+	for (unsigned int i = 0; i < m_renderedUnits.size(); i++)
+		if (i >= units.size() || !looksEqual(m_renderedUnits[i], units[i]))
+			dirtyRegions.push_back(UnitSpriteAtlas::bounds(m_renderedUnits[i]));
+
+	for (unsigned int i = 0; i < units.size(); i++)
+		if (i >= m_renderedUnits.size() || !looksEqual(m_renderedUnits[i], units[i]))
+		{
+			dirtyRegions.push_back(UnitSpriteAtlas::bounds(units[i]));
+			isDirty[i] = true;
+		}
+
+	// Units overlapping a dirty region are partially erased and thus have to
+	// be redrawn as a whole, which in turn dirties their region
+	bool hasDirtyRegionsChanged = true;
+
+	while (hasDirtyRegionsChanged)
+	{
+		hasDirtyRegionsChanged = false;
+
+		for (unsigned int i = 0; i < units.size(); i++)
+		{
+			if (isDirty[i])
+				continue;
+
+			cv::Rect bounds = UnitSpriteAtlas::bounds(units[i]);
+
+			if (!intersectsAny(bounds, dirtyRegions))
+				continue;
+
+			dirtyRegions.push_back(bounds);
+			isDirty[i] = true;
+			hasDirtyRegionsChanged = true;
+		}
+	}
+
+	cv::Rect imageRect(0, 0, image.cols, image.rows);
+
+	for (unsigned int i = 0; i < dirtyRegions.size(); i++)
+	{
+		cv::Rect region = dirtyRegions[i] & imageRect;
+
+		if (region.area() <= 0)
+			continue;
+
+		cv::Mat destinationRegion = image(region);
+		m_staticLayer(region).copyTo(destinationRegion);
+	}
+
+	// Keep the drawing order so that overlapping units look the same
+	for (unsigned int i = 0; i < units.size(); i++)
+		if (isDirty[i])
+			m_unitSpriteAtlas.render(image, units[i]);
+
+	m_renderedUnits = units;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RenderCache::haveObstaclesChanged(const GameObstacleStates &obstacles)
+	const
+{
+	if (obstacles.size() != m_renderedObstacles.size())
+		return true;
+
+	for (unsigned int i = 0; i < obstacles.size(); i++)
+	{
+		if (obstacles[i].position() != m_renderedObstacles[i].position()
+			|| obstacles[i].radius != m_renderedObstacles[i].radius)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void RenderCache::renderStaticLayer(const GameObstacleStates &obstacles)
+{
+	cv::rectangle(m_staticLayer, cv::Point(0, 0), cv::Point(480, 480),
+				  cv::Scalar(32, 32, 32), CV_FILLED);
+
+	cv::rectangle(m_staticLayer, cv::Point(0, 472), cv::Point(480, 480),
+				  cv::Scalar(32, 128, 64), CV_FILLED);
+
+	for (unsigned int i = 0; i < obstacles.size(); i++)
+		GameObstacle::render(m_staticLayer, obstacles[i]);
+
+	m_renderedObstacles = obstacles;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RenderCache::looksEqual(const GameUnitState &unit1,
+	const GameUnitState &unit2)
+{
+	return unit1.messageID == unit2.messageID
+		&& unit1.position() == unit2.position()
+		&& unit1.number == unit2.number
+		&& unit1.owner == unit2.owner
+		&& unit1.isHighlighted == unit2.isHighlighted
+		&& unit1.isLiving == unit2.isLiving
+		&& unit1.hasArrived == unit2.hasArrived;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool RenderCache::intersectsAny(const cv::Rect &rect,
+	const std::vector<cv::Rect> &rects)
+{
+	for (unsigned int i = 0; i < rects.size(); i++)
+		if ((rect & rects[i]).area() > 0)
+			return true;
+
+	return false;
+}
@@ -0,0 +1,71 @@
+#ifndef __GAME_RENDER_CACHE_H
+#define __GAME_RENDER_CACHE_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "GameState.h"
+#include "UnitSpriteAtlas.h"
+
+/**
+ * @class RenderCache
+ *
+ * @brief Renders game states incrementally.
+ *
+ * The background, the goal and the obstacles never move after a level has
+ * been loaded. They are rasterized once into a static layer. Each frame, only
+ * the regions of units that have moved or changed are restored from the static
+ * layer and drawn again, so that the render cost depends on the number of
+ * moving units instead of the image size.
+ */
+class RenderCache
+{
+	public:
+		RenderCache();
+
+		/**
+		 * @brief Renders a game state into an image.
+		 *
+		 * Updates the image rendered in the previous call. If the image is a
+		 * different one or the obstacles have changed, the whole image is
+		 * rendered again.
+		 *
+		 * @param image - The 480x480 image to render into.
+		 * @param gameState - The game state to render.
+		 */
+		void render(cv::Mat &image, const GameState &gameState);
+
+		/**
+		 * @brief Forces rendering the whole image in the next frame.
+		 */
+		void invalidate();
+
+	protected:
+		bool haveObstaclesChanged(const GameObstacleStates &obstacles) const;
+		void renderStaticLayer(const GameObstacleStates &obstacles);
+
+		static bool looksEqual(const GameUnitState &unit1,
+			const GameUnitState &unit2);
+		static bool intersectsAny(const cv::Rect &rect,
+			const std::vector<cv::Rect> &rects);
+
+		/** @brief Pre-rendered units. */
+		UnitSpriteAtlas m_unitSpriteAtlas;
+
+		/** @brief Background, goal and obstacles. */
+		cv::Mat m_staticLayer;
+
+		/** @brief The obstacles contained in the static layer. */
+		GameObstacleStates m_renderedObstacles;
+
+		/** @brief The units as they have been rendered in the last frame. */
+		GameUnitStates m_renderedUnits;
+
+		/** @brief The image rendered into in the last frame. */
+		const uchar *m_renderedImageData;
+
+		bool m_isValid;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "SelectionRequest.h"
+
+#include <boost/bind.hpp>
+
+#include "MessageTypes.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// SelectionRequest
+//
+////////////////////////////////////////////////////////////////////////////////
+
+SelectionRequest::SelectionRequest(GameNetworkInterface *gameNetworkInterface)
+	: MessageSchema(gameNetworkInterface)
+{
+	m_data.x = 0.0f;
+	m_data.y = 0.0f;
+	m_data.viewTime = 0;
+
+	setMessageID(MESSAGE_ID_EVENT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SelectionRequest::setPoint(cv::Point2f point)
+{
+	m_data.x = point.x;
+	m_data.y = point.y;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Point2f SelectionRequest::point()
+{
+	return cv::Point2f(m_data.x, m_data.y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SelectionRequest::setViewTime(boost::int64_t viewTime)
+{
+	m_data.viewTime = viewTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::int64_t SelectionRequest::viewTime()
+{
+	return m_data.viewTime;
+}
@@ -0,0 +1,38 @@
+#ifndef __GAME_SELECTION_REQUEST_H
+#define __GAME_SELECTION_REQUEST_H
+
+#include <boost/cstdint.hpp>
+
+#include <opencv2/core/core.hpp>
+
+#include "MessageSchema.h"
+#include "MessageTypes.h"
+#include "ForwardDeclarations.h"
+
+// Data to synchronize via network
+struct SelectionRequestData
+{
+	float x;
+	float y;
+
+	boost::int64_t viewTime;
+};
+
+// Asks the server to toggle the highlighting of the own unit at a touch point.
+// The server tests the point against the units as the client saw them at the
+// view time, given in microseconds of the server's clock. A view time of 0
+// tests against the current positions.
+class SelectionRequest : public MessageSchema<MESSAGE_SELECTION_REQUEST,
+	SelectionRequestData, UPDATE_FREQUENCY_ONCE>
+{
+	public:
+		SelectionRequest(GameNetworkInterface *gameNetworkInterface);
+
+		void setPoint(cv::Point2f point);
+		cv::Point2f point();
+
+		void setViewTime(boost::int64_t viewTime);
+		boost::int64_t viewTime();
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "ServerClock.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// ServerClock
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ServerClock::ServerClock()
+{
+	m_sampleCount = 0;
+	m_nextSample = 0;
+
+	m_offset = 0;
+	m_roundTripTime = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServerClock::Timestamp ServerClock::now()
+{
+	return boost::chrono::duration_cast<boost::chrono::microseconds>(
+		Clock::now().time_since_epoch()).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ServerClock::addSample(Timestamp requestTime, Timestamp serverTime,
+	Timestamp responseTime)
+{
+	Sample sample;
+	sample.roundTripTime = responseTime - requestTime;
+	sample.offset = serverTime - (requestTime + responseTime) / 2;
+
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	m_samples[m_nextSample] = sample;
+	m_nextSample = (m_nextSample + 1) % SAMPLES;
+
+	if (m_sampleCount < SAMPLES)
+		m_sampleCount++;
+
+	// Use the sample with the least delay
+	int best = 0;
+
+	for (int i = 1; i < m_sampleCount; i++)
+		if (m_samples[i].roundTripTime < m_samples[best].roundTripTime)
+			best = i;
+
+	m_offset = m_samples[best].offset;
+	m_roundTripTime = m_samples[best].roundTripTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ServerClock::isSynchronized() const
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	return m_sampleCount > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServerClock::Timestamp ServerClock::serverTime() const
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	return now() + m_offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServerClock::Clock::time_point ServerClock::localTime(Timestamp serverTime)
+	const
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	return Clock::time_point(boost::chrono::duration_cast<Clock::duration>(
+		boost::chrono::microseconds(serverTime - m_offset)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServerClock::Timestamp ServerClock::roundTripTime() const
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	return m_roundTripTime;
+}
@@ -0,0 +1,104 @@
+#ifndef __GAME_SERVER_CLOCK_H
+#define __GAME_SERVER_CLOCK_H
+
+#include <boost/chrono.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+/**
+ * @class ServerClock
+ *
+ * @brief Estimate of the server’s clock on a client.
+ *
+ * Timestamps are microseconds of a steady clock, whose origin differs between
+ * machines. The client exchanges its time with the server’s and assumes the
+ * server answered halfway through the round trip, as NTP does. Of the last
+ * samples, the one with the shortest round trip is the least affected by
+ * queuing delays, so its offset is used.
+ */
+class ServerClock
+{
+	public:
+		typedef boost::chrono::steady_clock Clock;
+
+		/** @brief Microseconds since the origin of a steady clock. */
+		typedef boost::int64_t Timestamp;
+
+		ServerClock();
+
+		/**
+		 * @brief Returns the current time of the local clock.
+		 *
+		 * The server stamps its messages with this time.
+		 *
+		 * @return The local timestamp.
+		 */
+		static Timestamp now();
+
+		/**
+		 * @brief Adds a clock sync exchange.
+		 *
+		 * @param requestTime - When the request was sent, in local time.
+		 * @param serverTime - When the server answered, in server time.
+		 * @param responseTime - When the answer arrived, in local time.
+		 */
+		void addSample(Timestamp requestTime, Timestamp serverTime,
+			Timestamp responseTime);
+
+		/**
+		 * @brief Whether the offset to the server’s clock is known.
+		 *
+		 * @return Whether at least one exchange has been completed.
+		 */
+		bool isSynchronized() const;
+
+		/**
+		 * @brief Returns the estimated current time of the server.
+		 *
+		 * @return The server timestamp or the local one if not synchronized.
+		 */
+		Timestamp serverTime() const;
+
+		/**
+		 * @brief Converts a server timestamp into local time.
+		 *
+		 * @param serverTime - The timestamp of the server.
+		 * @return The local time at which the server’s clock showed the time.
+		 */
+		Clock::time_point localTime(Timestamp serverTime) const;
+
+		/**
+		 * @brief Returns the round trip time of the sample used.
+		 *
+		 * @return The round trip time in microseconds.
+		 */
+		Timestamp roundTripTime() const;
+
+	protected:
+		/** @brief Number of exchanges the offset is chosen from. */
+		enum {SAMPLES = 8};
+
+		/**
+		 * @struct Sample
+		 *
+		 * @brief The result of a clock sync exchange.
+		 */
+		struct Sample
+		{
+			Timestamp offset;
+			Timestamp roundTripTime;
+		};
+
+		Sample m_samples[SAMPLES];
+		int m_sampleCount;
+		int m_nextSample;
+
+		/** @brief Server time minus local time of the best sample. */
+		Timestamp m_offset;
+		Timestamp m_roundTripTime;
+
+		/** @brief Mutex between the network and the reading threads. */
+		mutable boost::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "ThreadPool.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// ThreadPool
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool(unsigned int numberOfThreads)
+{
+	if (numberOfThreads == 0)
+		numberOfThreads = std::max(1u, boost::thread::hardware_concurrency());
+
+	m_queuedTasks = 0;
+	m_isStopping = false;
+
+	for (unsigned int i = 0; i < numberOfThreads; i++)
+		m_queues.push_back(new TaskQueue);
+
+	// The calling thread works on the first queue
+	for (unsigned int i = 1; i < numberOfThreads; i++)
+		m_threads.create_thread(boost::bind(&ThreadPool::work, this, i));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::~ThreadPool()
+{
+	m_wakeMutex.lock();
+	m_isStopping = true;
+	m_wakeMutex.unlock();
+
+	m_wakeCondition.notify_all();
+	m_threads.join_all();
+
+	for (unsigned int i = 0; i < m_queues.size(); i++)
+		delete m_queues[i];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int ThreadPool::numberOfThreads() const
+{
+	return m_queues.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::parallelFor(int begin, int end, int grainSize,
+	const RangeTask &task)
+{
+	if (begin >= end)
+		return;
+
+	grainSize = std::max(1, grainSize);
+
+	// Without helpers or with a single chunk, avoid the queueing overhead
+	if (m_queues.size() == 1 || end - begin <= grainSize)
+	{
+		task(begin, end);
+		return;
+	}
+
+	Batch batch;
+	batch.remainingTasks = (end - begin + grainSize - 1) / grainSize;
+
+	// Distribute the chunks evenly, stealing balances them later on
+	unsigned int queueIndex = 0;
+
+	for (int chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+	{
+		int chunkEnd = std::min(end, chunkBegin + grainSize);
+
+		push(queueIndex, boost::bind(&ThreadPool::runChunk, boost::cref(task),
+			chunkBegin, chunkEnd, &batch));
+
+		queueIndex = (queueIndex + 1) % m_queues.size();
+	}
+
+	m_wakeCondition.notify_all();
+
+	// Help processing until all chunks of this batch are done
+	Task nextTask;
+
+	while (take(0, nextTask))
+	{
+		nextTask();
+		nextTask.clear();
+	}
+
+	boost::unique_lock<boost::mutex> lock(batch.mutex);
+
+	while (batch.remainingTasks > 0)
+		batch.finishedCondition.wait(lock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::work(unsigned int queueIndex)
+{
+	Task nextTask;
+
+	while (true)
+	{
+		if (take(queueIndex, nextTask))
+		{
+			nextTask();
+			nextTask.clear();
+
+			continue;
+		}
+
+		boost::unique_lock<boost::mutex> lock(m_wakeMutex);
+
+		while (m_queuedTasks == 0 && !m_isStopping)
+			m_wakeCondition.wait(lock);
+
+		if (m_isStopping)
+			return;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::push(unsigned int queueIndex, const Task &task)
+{
+	TaskQueue *queue = m_queues[queueIndex];
+
+	queue->mutex.lock();
+	queue->tasks.push_back(task);
+	queue->mutex.unlock();
+
+	boost::lock_guard<boost::mutex> lock(m_wakeMutex);
+	m_queuedTasks++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ThreadPool::take(unsigned int queueIndex, Task &task)
+{
+	// Look at the own queue first, then try to steal from the others
+	for (unsigned int i = 0; i < m_queues.size(); i++)
+	{
+		bool isOwnQueue = (i == 0);
+		TaskQueue *queue = m_queues[(queueIndex + i) % m_queues.size()];
+
+		boost::lock_guard<boost::mutex> queueLock(queue->mutex);
+
+		if (queue->tasks.empty())
+			continue;
+
+		if (isOwnQueue)
+		{
+			task = queue->tasks.back();
+			queue->tasks.pop_back();
+		}
+		else
+		{
+			task = queue->tasks.front();
+			queue->tasks.pop_front();
+		}
+
+		boost::lock_guard<boost::mutex> wakeLock(m_wakeMutex);
+		m_queuedTasks--;
+
+		return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::runChunk(const RangeTask &task, int begin, int end,
+	Batch *batch)
+{
+	task(begin, end);
+
+	boost::lock_guard<boost::mutex> lock(batch->mutex);
+
+	if (--batch->remainingTasks == 0)
+		batch->finishedCondition.notify_all();
+}
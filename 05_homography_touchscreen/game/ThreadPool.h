@@ -0,0 +1,100 @@
+#ifndef __GENERAL_THREAD_POOL_H
+#define __GENERAL_THREAD_POOL_H
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+/**
+ * @class ThreadPool
+ *
+ * @brief Work-stealing pool of worker threads.
+ *
+ * Each worker owns a task queue. Workers take tasks from the back of their own
+ * queue and steal from the front of the other queues once theirs is empty, so
+ * that unevenly expensive chunks of work are balanced automatically.
+ */
+class ThreadPool : private boost::noncopyable
+{
+	public:
+		/** @brief Function processing the index range [begin, end). */
+		typedef boost::function<void (int, int)> RangeTask;
+
+		/**
+		 * @brief Creates a thread pool.
+		 *
+		 * Starts the worker threads. The thread calling parallelFor takes part
+		 * in the work as well, so one thread less than requested is started.
+		 *
+		 * @param numberOfThreads - The number of threads working in parallel.
+		 *     If 0, the number of hardware threads is used.
+		 */
+		ThreadPool(unsigned int numberOfThreads = 0);
+		~ThreadPool();
+
+		/**
+		 * @brief Returns the number of threads working in parallel.
+		 *
+		 * @return The number of worker threads including the calling thread.
+		 */
+		unsigned int numberOfThreads() const;
+
+		/**
+		 * @brief Processes an index range in parallel.
+		 *
+		 * Splits [begin, end) into chunks of at most grainSize indices and
+		 * runs the task on them in parallel. Returns when all chunks have been
+		 * processed. Must not be called from within a task.
+		 *
+		 * @param begin - The first index to process.
+		 * @param end - The index after the last one to process.
+		 * @param grainSize - The maximal number of indices per chunk.
+		 * @param task - The function processing a chunk.
+		 */
+		void parallelFor(int begin, int end, int grainSize,
+			const RangeTask &task);
+
+	protected:
+		typedef boost::function<void ()> Task;
+
+		/** @brief Task queue owned by one thread. */
+		struct TaskQueue
+		{
+			std::deque<Task> tasks;
+			boost::mutex mutex;
+		};
+
+		/** @brief Keeps track of the chunks of one parallelFor call. */
+		struct Batch
+		{
+			int remainingTasks;
+			boost::mutex mutex;
+			boost::condition_variable finishedCondition;
+		};
+
+		void work(unsigned int queueIndex);
+
+		void push(unsigned int queueIndex, const Task &task);
+		bool take(unsigned int queueIndex, Task &task);
+
+		static void runChunk(const RangeTask &task, int begin, int end,
+			Batch *batch);
+
+		/** @brief Task queues, the first one belongs to the calling thread. */
+		std::vector<TaskQueue*> m_queues;
+
+		boost::thread_group m_threads;
+
+		/** @brief Number of tasks that have been pushed but not taken yet. */
+		int m_queuedTasks;
+
+		bool m_isStopping;
+
+		boost::mutex m_wakeMutex;
+		boost::condition_variable m_wakeCondition;
+};
+
+#endif
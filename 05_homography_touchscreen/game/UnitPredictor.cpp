@@ -0,0 +1,204 @@
+#include "UnitPredictor.h"
+
+#include <algorithm>
+
+#include "GameUnit.h"
+#include "GameState.h"
+#include "ServerClock.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// UnitPredictor
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Simulate in steps no longer than the ones of the server
+const float UnitPredictor::s_maximalTimeStep = 0.02f;
+
+// Keeps the replay short if the server stops sending
+const boost::chrono::seconds UnitPredictor::s_maximalPredictionDuration(1);
+
+const float UnitPredictor::s_roundTripTimeWeight = 0.1f;
+
+////////////////////////////////////////////////////////////////////////////////
+
+UnitPredictor::UnitPredictor()
+{
+	m_roundTripTime = -1.0f;
+	m_serverClock = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitPredictor::setServerClock(const ServerClock *serverClock)
+{
+	m_serverClock = serverClock;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitPredictor::addInput(const GameUnitState &gameUnit,
+	uint32_t inputSequence, cv::Vec2f acceleration, Clock::time_point time)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	Prediction &prediction = m_predictions[gameUnit.messageID];
+
+	if (!prediction.base)
+	{
+		prediction.base = GameUnitPtr(new GameUnit(NULL));
+		prediction.base->adoptState(gameUnit);
+		prediction.baseTime = time;
+	}
+
+	Input input;
+	input.sequence = inputSequence;
+	input.acceleration = acceleration;
+	input.time = time;
+
+	prediction.inputs.push_back(input);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitPredictor::reconcile(const GameUnit &gameUnit, Clock::time_point time)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	Predictions::iterator i = m_predictions.find(gameUnit.messageID());
+
+	if (i == m_predictions.end())
+		return;
+
+	Prediction &prediction = i->second;
+
+	// Drop the move requests the server has applied, measuring the round trip
+	// of the last one
+	while (!prediction.inputs.empty()
+		&& prediction.inputs.front().sequence <= gameUnit.inputSequence())
+	{
+		if (prediction.inputs.front().sequence == gameUnit.inputSequence())
+		{
+			float roundTripTime = boost::chrono::duration<float>(
+				time - prediction.inputs.front().time).count();
+
+			if (m_roundTripTime < 0.0f)
+				m_roundTripTime = roundTripTime;
+			else
+				m_roundTripTime += s_roundTripTimeWeight
+					* (roundTripTime - m_roundTripTime);
+		}
+
+		prediction.inputs.pop_front();
+	}
+
+	prediction.base->adoptState(gameUnit);
+	prediction.baseTime = time;
+
+	if (m_serverClock && m_serverClock->isSynchronized()
+		&& gameUnit.serverTime() != 0)
+		prediction.baseTime = m_serverClock->localTime(gameUnit.serverTime());
+	else if (m_roundTripTime > 0.0f)
+		prediction.baseTime -= boost::chrono::duration_cast<Clock::duration>(
+			boost::chrono::duration<float>(m_roundTripTime / 2.0f));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GameStatePtr UnitPredictor::apply(const GameStatePtr &gameState,
+	Clock::time_point time) const
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	if (!gameState || m_predictions.empty())
+		return gameState;
+
+	GameState *predictedState = new GameState;
+	predictedState->setOwnPlayerID(gameState->ownPlayerID());
+
+	for (unsigned int i = 0; i < gameState->obstacles().size(); i++)
+		predictedState->addObstacle(gameState->obstacles()[i]);
+
+	GameUnit gameUnit(NULL);
+
+	for (unsigned int i = 0; i < gameState->units().size(); i++)
+	{
+		GameUnitState unit = gameState->units()[i];
+
+		Predictions::const_iterator prediction
+			= m_predictions.find(unit.messageID);
+
+		if (prediction != m_predictions.end())
+		{
+			simulate(prediction->second, gameState->obstacles(), time,
+				gameUnit);
+
+			unit.x = gameUnit.x();
+			unit.y = gameUnit.y();
+		}
+
+		predictedState->addUnit(unit);
+	}
+
+	return GameStatePtr(predictedState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitPredictor::clear()
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+
+	m_predictions.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitPredictor::simulate(const Prediction &prediction,
+	const GameObstacleStates &gameObstacles, Clock::time_point time,
+	GameUnit &gameUnit)
+{
+	gameUnit.adoptState(*prediction.base);
+
+	Clock::time_point simulatedTime = prediction.baseTime;
+
+	if (time > simulatedTime + s_maximalPredictionDuration)
+		time = simulatedTime + s_maximalPredictionDuration;
+
+	// Replay the pending move requests at the time they have been sent
+	for (std::deque<Input>::const_iterator input = prediction.inputs.begin();
+		input != prediction.inputs.end(); input++)
+	{
+		if (input->time > time)
+			break;
+
+		if (input->time > simulatedTime)
+		{
+			simulate(gameUnit, gameObstacles, boost::chrono::duration<float>(
+				input->time - simulatedTime).count());
+
+			simulatedTime = input->time;
+		}
+
+		gameUnit.setAcceleration(input->acceleration);
+	}
+
+	if (time > simulatedTime)
+		simulate(gameUnit, gameObstacles,
+			boost::chrono::duration<float>(time - simulatedTime).count());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitPredictor::simulate(GameUnit &gameUnit,
+	const GameObstacleStates &gameObstacles, float duration)
+{
+	while (duration > 0.0f)
+	{
+		float timeStep = std::min(duration, s_maximalTimeStep);
+
+		gameUnit.simulate(timeStep, gameObstacles);
+
+		duration -= timeStep;
+	}
+}
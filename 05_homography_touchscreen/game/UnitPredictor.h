@@ -0,0 +1,156 @@
+#ifndef __GAME_UNIT_PREDICTOR_H
+#define __GAME_UNIT_PREDICTOR_H
+
+#include <boost/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+#include <map>
+
+#include <opencv2/core/core.hpp>
+
+#include "MessageData.h"
+#include "ForwardDeclarations.h"
+
+class ServerClock;
+
+/**
+ * @class UnitPredictor
+ *
+ * @brief Predicts the own units of a client ahead of the server.
+ *
+ * Each move request is applied locally at once, so that the player sees the
+ * unit react without waiting for the server. The predictor keeps the move
+ * requests the server has not applied yet, identified by their input
+ * sequence number. When an authoritative state of a unit arrives, the unit is
+ * reset to that state and the pending requests are replayed on top of it with
+ * the same physics the server runs.
+ *
+ * States are dated by their server timestamp if the server’s clock is known.
+ * Otherwise, they are assumed to be half a round trip old, with the round trip
+ * time measured from the acknowledged move requests.
+ */
+class UnitPredictor
+{
+	public:
+		typedef boost::chrono::steady_clock Clock;
+
+		UnitPredictor();
+
+		/**
+		 * @brief Uses the server’s clock to date authoritative states.
+		 *
+		 * Without a synchronized clock, states are assumed to be half a round
+		 * trip old. The clock has to outlive the predictor.
+		 *
+		 * @param serverClock - The estimate of the server’s clock.
+		 */
+		void setServerClock(const ServerClock *serverClock);
+
+		/**
+		 * @brief Applies a move request locally.
+		 *
+		 * Starts predicting the unit from the given state if it is not
+		 * predicted yet. The state is taken from a published snapshot, as the
+		 * network thread may modify the unit meanwhile.
+		 *
+		 * @param gameUnit - The state of the unit to move.
+		 * @param inputSequence - The sequence number of the move request.
+		 * @param acceleration - The acceleration requested.
+		 * @param time - When the request has been sent.
+		 */
+		void addInput(const GameUnitState &gameUnit, uint32_t inputSequence,
+			cv::Vec2f acceleration, Clock::time_point time);
+
+		/**
+		 * @brief Resets a predicted unit to its authoritative state.
+		 *
+		 * Drops all move requests the server has applied according to the
+		 * unit’s input sequence. Units not predicted are ignored.
+		 *
+		 * @param gameUnit - The unit as received from the server.
+		 * @param time - When the state has been received.
+		 */
+		void reconcile(const GameUnit &gameUnit, Clock::time_point time);
+
+		/**
+		 * @brief Replaces the predicted units in a game state.
+		 *
+		 * The units collide with the obstacles of the given state.
+		 *
+		 * @param gameState - The state to display.
+		 * @param time - The time to predict the units for.
+		 * @return The state with the predicted units.
+		 */
+		GameStatePtr apply(const GameStatePtr &gameState,
+			Clock::time_point time) const;
+
+		/**
+		 * @brief Stops predicting all units.
+		 */
+		void clear();
+
+	protected:
+		/** @brief Maximal time step of the simulation, one server step. */
+		static const float s_maximalTimeStep;
+
+		/** @brief Units are predicted at most this far beyond their state. */
+		static const boost::chrono::seconds s_maximalPredictionDuration;
+
+		/** @brief Weight of a new round trip time measurement. */
+		static const float s_roundTripTimeWeight;
+
+		/**
+		 * @struct Input
+		 *
+		 * @brief A move request not yet applied by the server.
+		 */
+		struct Input
+		{
+			uint32_t sequence;
+			cv::Vec2f acceleration;
+			Clock::time_point time;
+		};
+
+		/**
+		 * @struct Prediction
+		 *
+		 * @brief The last authoritative state of a unit and the move requests
+		 *     sent since.
+		 */
+		struct Prediction
+		{
+			GameUnitPtr base;
+			Clock::time_point baseTime;
+			std::deque<Input> inputs;
+		};
+
+		typedef std::map<MessageID, Prediction> Predictions;
+
+		/**
+		 * @brief Simulates a unit from its last authoritative state.
+		 *
+		 * @param prediction - The state and the pending move requests.
+		 * @param gameObstacles - The obstacles the unit collides with.
+		 * @param time - The time to simulate the unit up to.
+		 * @param gameUnit - (out) The predicted unit.
+		 */
+		static void simulate(const Prediction &prediction,
+			const GameObstacleStates &gameObstacles, Clock::time_point time,
+			GameUnit &gameUnit);
+
+		static void simulate(GameUnit &gameUnit,
+			const GameObstacleStates &gameObstacles, float duration);
+
+		Predictions m_predictions;
+
+		const ServerClock *m_serverClock;
+
+		/** @brief Smoothed round trip time, negative until measured. */
+		float m_roundTripTime;
+
+		/** @brief Mutex between input, network and rendering threads. */
+		mutable boost::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "UnitSpriteAtlas.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "GameUnit.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// UnitSpriteAtlas
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// Large enough for the highlight ring and three-digit numbers
+const int UnitSpriteAtlas::s_spriteRadius = 20;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void UnitSpriteAtlas::render(cv::Mat &image, const GameUnitState &gameUnitState)
+{
+	unsigned int key = appearance(gameUnitState);
+
+	Sprites::iterator sprite = m_sprites.find(key);
+
+	if (sprite == m_sprites.end())
+		sprite = m_sprites.insert(
+			std::make_pair(key, rasterize(gameUnitState))).first;
+
+	// Clip the sprite at the image borders
+	cv::Rect spriteBounds = bounds(gameUnitState);
+	cv::Rect destination = spriteBounds & cv::Rect(0, 0, image.cols, image.rows);
+
+	if (destination.area() <= 0)
+		return;
+
+	cv::Rect source(destination.x - spriteBounds.x,
+					destination.y - spriteBounds.y,
+					destination.width, destination.height);
+
+	cv::Mat destinationRegion = image(destination);
+
+	// Blend the premultiplied sprite over the image: the image is attenuated
+	// by the sprite's transparency and the sprite's colour is added. Both are
+	// vectorized operations of OpenCV working on a few hundred bytes only.
+	cv::multiply(destinationRegion, (*sprite).second.inverseAlpha(source),
+				 m_blendBuffer, 1.0 / 255.0);
+	cv::add(m_blendBuffer, (*sprite).second.color(source), destinationRegion);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+cv::Rect UnitSpriteAtlas::bounds(const GameUnitState &gameUnitState)
+{
+	cv::Point position = gameUnitState.position();
+
+	return cv::Rect(position.x - s_spriteRadius, position.y - s_spriteRadius,
+					2 * s_spriteRadius + 1, 2 * s_spriteRadius + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int UnitSpriteAtlas::appearance(const GameUnitState &gameUnitState)
+{
+	const GameUnitState &unit = gameUnitState;
+
+	// Same distinction as in GameUnit::render
+	unsigned int color;
+
+	if (unit.hasArrived)
+		color = 0;
+	else if (!unit.isLiving)
+		color = 1;
+	else if (unit.owner == ID_FIRST_CLIENT)
+		color = 2;
+	else
+		color = 3;
+
+	unsigned int isHighlighted
+		= (unit.isHighlighted && unit.isLiving && !unit.hasArrived) ? 1 : 0;
+
+	return unit.number | (color << 8) | (isHighlighted << 10);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+UnitSpriteAtlas::Sprite UnitSpriteAtlas::rasterize(
+	const GameUnitState &gameUnitState)
+{
+	int size = 2 * s_spriteRadius + 1;
+
+	// Draw the unit in the center of the sprite
+	GameUnitState centeredUnit = gameUnitState;
+	centeredUnit.x = s_spriteRadius;
+	centeredUnit.y = s_spriteRadius;
+
+	// Drawing onto black yields the colour premultiplied with the coverage,
+	// the difference to drawing onto white yields the transparency
+	cv::Mat onBlack(size, size, CV_8UC3, cv::Scalar(0, 0, 0));
+	cv::Mat onWhite(size, size, CV_8UC3, cv::Scalar(255, 255, 255));
+
+	GameUnit::render(onBlack, centeredUnit);
+	GameUnit::render(onWhite, centeredUnit);
+
+	Sprite sprite;
+	sprite.color = onBlack;
+	cv::subtract(onWhite, onBlack, sprite.inverseAlpha);
+
+	return sprite;
+}
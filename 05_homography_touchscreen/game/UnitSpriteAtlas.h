@@ -0,0 +1,68 @@
+#ifndef __GAME_UNIT_SPRITE_ATLAS_H
+#define __GAME_UNIT_SPRITE_ATLAS_H
+
+#include <map>
+
+#include <opencv2/core/core.hpp>
+
+#include "GameState.h"
+
+/**
+ * @class UnitSpriteAtlas
+ *
+ * @brief Pre-rendered images of game units.
+ *
+ * Drawing antialiased circles and Hershey text for every unit in every frame
+ * is expensive. Units only differ in their position, number and a few colour
+ * and highlight states, so each appearance is rasterized once into a sprite
+ * and afterwards just blended into the image.
+ */
+class UnitSpriteAtlas
+{
+	public:
+		/**
+		 * @brief Draws a unit.
+		 *
+		 * Blends the unit’s sprite into the image, rasterizing the sprite
+		 * first if the unit’s appearance has not been drawn before.
+		 *
+		 * @param image - The CV_8UC3 image to draw into.
+		 * @param gameUnitState - The unit to draw.
+		 */
+		void render(cv::Mat &image, const GameUnitState &gameUnitState);
+
+		/**
+		 * @brief Returns the area a unit covers in the image.
+		 *
+		 * @param gameUnitState - The unit whose sprite area to return.
+		 *
+		 * @return The area covered by the unit’s sprite.
+		 */
+		static cv::Rect bounds(const GameUnitState &gameUnitState);
+
+	protected:
+		/** @brief Appearance of a unit as rendered onto black. */
+		struct Sprite
+		{
+			/** @brief Colour premultiplied with the coverage. */
+			cv::Mat color;
+
+			/** @brief 255 minus the coverage per channel. */
+			cv::Mat inverseAlpha;
+		};
+
+		typedef std::map<unsigned int, Sprite> Sprites;
+
+		static unsigned int appearance(const GameUnitState &gameUnitState);
+		static Sprite rasterize(const GameUnitState &gameUnitState);
+
+		/** @brief Half the edge length of a sprite. */
+		static const int s_spriteRadius;
+
+		Sprites m_sprites;
+
+		/** @brief Buffer for blending. */
+		cv::Mat m_blendBuffer;
+};
+
+#endif
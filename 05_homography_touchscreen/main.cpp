@@ -1,8 +1,47 @@
 #include "Application.h"
 
+#include <sstream>
+
+#include "DepthCamera.h"
+#include "DepthCameraException.h"
+#include "SessionReplay.h"
+#include "SyntheticFrameSource.h"
+#include "game/Logging.h"
+
+FrameSource *createFrameSource(int argc, char *argv[])
+{
+	// Replay a recorded session if one is passed as the second argument
+	if (argc > 2)
+	{
+		SessionReplay *sessionReplay = new SessionReplay;
+
+		if (sessionReplay->open(argv[2]))
+		{
+			sessionReplay->setLooping(true);
+			return sessionReplay;
+		}
+
+		delete sessionReplay;
+	}
+
+	try
+	{
+		return DepthCamera::instance();
+	}
+	catch (DepthCameraException &exception)
+	{
+		std::stringstream message;
+		message << "No depth camera available (" << exception.what()
+			<< "), using synthetic frames.";
+		Logging::info(message.str());
+	}
+
+	return new SyntheticFrameSource;
+}
+
 int main(int argc, char *argv[])
 {
-    Application application(argc, argv);
+    Application application(argc, argv, createFrameSource(argc, argv));
 
     while (!application.isFinished())
 		application.loop();